@@ -0,0 +1,404 @@
+/*
+  ==============================================================================
+
+    AllocationTrap.cpp
+
+    Replaces the global operator new and delete, and hooks the C allocator
+    where the platform allows it, to check for them on a trapped thread.
+    See AllocationTrap.h.
+
+  ==============================================================================
+*/
+
+#include "AllocationTrap.h"
+
+#if ELOUREVERB_ALLOCATION_TRAP
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#if JUCE_MAC
+ #include <malloc/malloc.h>
+ #include <mach/mach.h>
+ #include <pthread.h>
+#endif
+
+namespace
+{
+    std::atomic<int> numTrapped { 0 };
+
+    // Set once the C allocator is hooked. operator new and delete go through
+    // malloc and free, so from then on they leave the check to the hooks
+    // rather than count every C++ allocation twice.
+    std::atomic<bool> mallocHooked { false };
+
+   #if JUCE_MAC
+    // A thread_local in a dylib is allocated with malloc on each thread's
+    // first use, which would re-enter the zone hooks. A pthread key isn't.
+    pthread_key_t getTrapDepthKey() noexcept
+    {
+        static const pthread_key_t key = [] {
+            pthread_key_t newKey {};
+            pthread_key_create(&newKey, nullptr);
+            return newKey;
+        }();
+        return key;
+    }
+
+    int getTrapDepth() noexcept           { return (int) reinterpret_cast<intptr_t>(pthread_getspecific(getTrapDepthKey())); }
+    void setTrapDepth(int depth) noexcept { pthread_setspecific(getTrapDepthKey(), reinterpret_cast<void*>((intptr_t) depth)); }
+   #else
+    thread_local int trapDepth = 0;
+
+    int getTrapDepth() noexcept           { return trapDepth; }
+    void setTrapDepth(int depth) noexcept { trapDepth = depth; }
+   #endif
+
+    void checkAllocation() noexcept
+    {
+        const int depth = getTrapDepth();
+        if (depth == 0)
+            return;
+
+        numTrapped.fetch_add(1);
+
+        // The assertion handler may allocate itself, so disarm while it runs
+        setTrapDepth(0);
+        jassertfalse; // Memory allocated or freed on the audio thread
+        setTrapDepth(depth);
+    }
+
+    // What operator new and delete check themselves
+    void checkCppAllocation() noexcept
+    {
+        if (! mallocHooked.load(std::memory_order_relaxed))
+            checkAllocation();
+    }
+}
+
+ScopedAllocationTrap::ScopedAllocationTrap() noexcept    { setTrapDepth(getTrapDepth() + 1); }
+ScopedAllocationTrap::~ScopedAllocationTrap() noexcept   { setTrapDepth(getTrapDepth() - 1); }
+
+int ScopedAllocationTrap::getNumTrappedAllocations() noexcept
+{
+    return numTrapped.load();
+}
+
+bool ScopedAllocationTrap::isTrappingMalloc() noexcept
+{
+    return mallocHooked.load();
+}
+
+//==============================================================================
+#if JUCE_LINUX && defined (__GLIBC__)
+// Interposes the C allocator over glibc's, which stays reachable through its
+// __libc_ entry points. This only takes effect where these definitions come
+// first in symbol lookup: when the trap is linked into an executable, such as
+// the unit tests or a standalone build. A plugin loaded into a host still
+// gets the host's malloc, and only its C++ allocations are checked.
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void __libc_free (void*);
+
+    void* malloc(size_t size) noexcept
+    {
+        if (! mallocHooked.load(std::memory_order_relaxed))
+            mallocHooked.store(true);
+
+        checkAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t numItems, size_t size) noexcept
+    {
+        checkAllocation();
+        return __libc_calloc(numItems, size);
+    }
+
+    void* realloc(void* memory, size_t size) noexcept
+    {
+        checkAllocation();
+        return __libc_realloc(memory, size);
+    }
+
+    void* memalign(size_t alignment, size_t size) noexcept
+    {
+        checkAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        return memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size) noexcept
+    {
+        if (alignment % sizeof(void*) != 0 || ! juce::isPowerOfTwo(alignment))
+            return EINVAL;
+
+        void* memory = memalign(alignment, size);
+        if (memory == nullptr)
+            return ENOMEM;
+
+        *result = memory;
+        return 0;
+    }
+
+    void free(void* memory) noexcept
+    {
+        if (memory != nullptr)
+            checkAllocation();
+
+        __libc_free(memory);
+    }
+}
+#endif
+
+//==============================================================================
+#if JUCE_MAC
+namespace
+{
+    // Every malloc zone registered at load time has its entry points swapped
+    // for checking ones that forward to the originals, and restored when the
+    // plugin is unloaded. Zones registered later are not seen.
+    struct HookedZone
+    {
+        malloc_zone_t* zone;
+        malloc_zone_t original;
+    };
+
+    constexpr int maxHookedZones = 16;
+    HookedZone hookedZones[maxHookedZones];
+    int numHookedZones = 0;
+
+    const malloc_zone_t& getOriginal(malloc_zone_t* zone) noexcept
+    {
+        for (int i = 0; i < numHookedZones; ++i)
+            if (hookedZones[i].zone == zone)
+                return hookedZones[i].original;
+
+        return hookedZones[0].original;
+    }
+
+    void* zoneMalloc(malloc_zone_t* zone, size_t size)
+    {
+        checkAllocation();
+        return getOriginal(zone).malloc(zone, size);
+    }
+
+    void* zoneCalloc(malloc_zone_t* zone, size_t numItems, size_t size)
+    {
+        checkAllocation();
+        return getOriginal(zone).calloc(zone, numItems, size);
+    }
+
+    void* zoneValloc(malloc_zone_t* zone, size_t size)
+    {
+        checkAllocation();
+        return getOriginal(zone).valloc(zone, size);
+    }
+
+    void* zoneRealloc(malloc_zone_t* zone, void* memory, size_t size)
+    {
+        checkAllocation();
+        return getOriginal(zone).realloc(zone, memory, size);
+    }
+
+    void* zoneMemalign(malloc_zone_t* zone, size_t alignment, size_t size)
+    {
+        checkAllocation();
+        return getOriginal(zone).memalign(zone, alignment, size);
+    }
+
+    void zoneFree(malloc_zone_t* zone, void* memory)
+    {
+        if (memory != nullptr)
+            checkAllocation();
+
+        getOriginal(zone).free(zone, memory);
+    }
+
+    void zoneFreeDefiniteSize(malloc_zone_t* zone, void* memory, size_t size)
+    {
+        if (memory != nullptr)
+            checkAllocation();
+
+        getOriginal(zone).free_definite_size(zone, memory, size);
+    }
+
+    // Zones are read-only from version 8 on, so each is made writable while
+    // it is patched
+    template <typename Patch>
+    void patchZone(malloc_zone_t* zone, Patch&& patch)
+    {
+        const bool isProtected = zone->version >= 8;
+        const auto address = reinterpret_cast<vm_address_t>(zone);
+
+        if (isProtected)
+            vm_protect(mach_task_self(), address, sizeof(malloc_zone_t), 0, VM_PROT_READ | VM_PROT_WRITE);
+
+        patch(*zone);
+
+        if (isProtected)
+            vm_protect(mach_task_self(), address, sizeof(malloc_zone_t), 0, VM_PROT_READ);
+    }
+
+    struct ZoneHooks
+    {
+        ZoneHooks()
+        {
+            vm_address_t* zones = nullptr;
+            unsigned int numZones = 0;
+
+            if (malloc_get_all_zones(mach_task_self(), nullptr, &zones, &numZones) != KERN_SUCCESS)
+                return;
+
+            for (unsigned int i = 0; i < numZones && numHookedZones < maxHookedZones; ++i) {
+                auto* zone = reinterpret_cast<malloc_zone_t*>(zones[i]);
+                hookedZones[numHookedZones++] = { zone, *zone };
+
+                patchZone(zone, [](malloc_zone_t& z) {
+                    z.malloc = zoneMalloc;
+                    z.calloc = zoneCalloc;
+                    z.valloc = zoneValloc;
+                    z.realloc = zoneRealloc;
+                    z.free = zoneFree;
+
+                    if (z.version >= 5 && z.memalign != nullptr)
+                        z.memalign = zoneMemalign;
+                    if (z.version >= 6 && z.free_definite_size != nullptr)
+                        z.free_definite_size = zoneFreeDefiniteSize;
+                });
+            }
+
+            mallocHooked.store(numHookedZones > 0);
+        }
+
+        ~ZoneHooks()
+        {
+            mallocHooked.store(false);
+
+            for (int i = 0; i < numHookedZones; ++i) {
+                const malloc_zone_t& original = hookedZones[i].original;
+
+                patchZone(hookedZones[i].zone, [&original](malloc_zone_t& z) {
+                    z.malloc = original.malloc;
+                    z.calloc = original.calloc;
+                    z.valloc = original.valloc;
+                    z.realloc = original.realloc;
+                    z.free = original.free;
+
+                    if (z.version >= 5)
+                        z.memalign = original.memalign;
+                    if (z.version >= 6)
+                        z.free_definite_size = original.free_definite_size;
+                });
+            }
+        }
+    };
+
+    const ZoneHooks zoneHooks;
+}
+#endif
+
+//==============================================================================
+namespace
+{
+    void* allocate(std::size_t size) noexcept
+    {
+        checkCppAllocation();
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void deallocate(void* memory) noexcept
+    {
+        if (memory != nullptr)
+            checkCppAllocation();
+
+        std::free(memory);
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+    {
+        checkCppAllocation();
+
+        const auto bytes = size == 0 ? 1 : size;
+        const auto align = juce::jmax(static_cast<std::size_t>(alignment), sizeof(void*));
+
+       #if JUCE_WINDOWS
+        return _aligned_malloc(bytes, align);
+       #else
+        void* memory = nullptr;
+        return posix_memalign(&memory, align, bytes) == 0 ? memory : nullptr;
+       #endif
+    }
+
+    void deallocateAligned(void* memory) noexcept
+    {
+        if (memory != nullptr)
+            checkCppAllocation();
+
+       #if JUCE_WINDOWS
+        _aligned_free(memory);
+       #else
+        std::free(memory);
+       #endif
+    }
+}
+
+// Every replaceable form is defined, since the library's own array, nothrow
+// and aligned forms don't all forward to the plain ones
+void* operator new(std::size_t size)
+{
+    if (void* memory = allocate(size))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)                                    { return operator new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept      { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept    { return allocate(size); }
+
+void operator delete(void* memory) noexcept                               { deallocate(memory); }
+void operator delete[](void* memory) noexcept                             { deallocate(memory); }
+void operator delete(void* memory, std::size_t) noexcept                  { deallocate(memory); }
+void operator delete[](void* memory, std::size_t) noexcept                { deallocate(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept        { deallocate(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept      { deallocate(memory); }
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void* memory = allocateAligned(size, alignment))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)        { return operator new(size, alignment); }
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept                                 { deallocateAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept                               { deallocateAligned(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept                    { deallocateAligned(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept                  { deallocateAligned(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept          { deallocateAligned(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept        { deallocateAligned(memory); }
+
+#endif
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    AllocationTrap.h
+
+    Debug check that the audio thread never allocates or frees memory.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// On by default in debug builds. Define ELOUREVERB_ALLOCATION_TRAP=1 to keep
+// it in a release build you are testing, or =0 to build without it.
+#ifndef ELOUREVERB_ALLOCATION_TRAP
+ #if JUCE_DEBUG
+  #define ELOUREVERB_ALLOCATION_TRAP 1
+ #else
+  #define ELOUREVERB_ALLOCATION_TRAP 0
+ #endif
+#endif
+
+//==============================================================================
+/**
+    While a ScopedAllocationTrap is alive, any allocation or free on the same
+    thread is counted and hits a jassert. Other threads, such as the
+    convolution tail worker, are not affected.
+
+    processBlock holds one for the whole block, so running the plugin in a
+    debug build and moving every parameter through every bus layout proves
+    the audio path allocation-free. Everything it needs is allocated in
+    prepareToPlay or off the audio thread.
+
+    Every form of operator new and delete is replaced. The C allocator, which
+    JUCE's HeapBlock and AudioBuffer use directly, is checked too where it can
+    be hooked: through the malloc zones on macOS, and by interposing malloc,
+    calloc, realloc and free in executables on Linux (see isTrappingMalloc()).
+    Without ELOUREVERB_ALLOCATION_TRAP the class is empty and costs nothing.
+*/
+class ScopedAllocationTrap
+{
+public:
+   #if ELOUREVERB_ALLOCATION_TRAP
+    ScopedAllocationTrap() noexcept;
+    ~ScopedAllocationTrap() noexcept;
+
+    // Allocations caught so far, on any thread
+    static int getNumTrappedAllocations() noexcept;
+
+    // True when malloc and free are checked as well as operator new and delete
+    static bool isTrappingMalloc() noexcept;
+   #else
+    ScopedAllocationTrap() noexcept {}
+    static int getNumTrappedAllocations() noexcept { return 0; }
+    static bool isTrappingMalloc() noexcept { return false; }
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedAllocationTrap)
+};
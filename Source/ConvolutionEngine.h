@@ -0,0 +1,502 @@
+/*
+  ==============================================================================
+
+    ConvolutionEngine.h
+
+    Partitioned FFT convolution for the impulse-response mode: a uniform
+    zero-latency head on the audio thread and a long-partition tail on a
+    worker thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Zero-latency, uniformly partitioned overlap-save convolver (one channel).
+
+    The impulse response is cut into blockSize partitions. Each is transformed
+    once with a 2 * blockSize FFT. Input spectra go into a frequency-domain
+    delay line. Spectra are kept in split (real / imaginary) form, so the
+    complex multiply-accumulate over partitions is straight SIMD arithmetic.
+
+    Host blocks shorter than blockSize are handled the same way as
+    juce::dsp::Convolution. The partially filled input block is re-transformed
+    on every call. The older partitions are summed only once per block.
+
+    prepare() allocates everything. process() never allocates.
+*/
+class UniformConvolver
+{
+public:
+    // Allocates, so call this from the message thread or prepareToPlay
+    void prepare(const float* impulse, int impulseLength, int blockSizeToUse)
+    {
+        blockSize = juce::nextPowerOfTwo(juce::jlimit(32, 16384, blockSizeToUse));
+        fftSize = 2 * blockSize;
+        fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2((double) fftSize)));
+
+        numVecs = (blockSize + 1 + lanesPerVec - 1) / lanesPerVec;
+        numPartitions = juce::jmax(1, (impulseLength + blockSize - 1) / blockSize);
+
+        const auto zero = Vec::expand(0.0f);
+        fftBuffer.assign((size_t) (2 * fftSize), 0.0f);
+        inputWindow.assign((size_t) fftSize, 0.0f);
+        impulseSpectra.assign((size_t) (numPartitions * spectrumSize()), zero);
+        inputSpectra.assign((size_t) (numPartitions * spectrumSize()), zero);
+        currentSpectrum.assign((size_t) spectrumSize(), zero);
+        tailSpectrum.assign((size_t) spectrumSize(), zero);
+        outputSpectrum.assign((size_t) spectrumSize(), zero);
+
+        for (int p = 0; p < numPartitions; ++p) {
+            const int start = p * blockSize;
+            const int num = juce::jmin(blockSize, impulseLength - start);
+
+            std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+            std::copy(impulse + start, impulse + start + num, fftBuffer.begin());
+            fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+            splitSpectrum(partition(impulseSpectra, p));
+        }
+
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        const auto zero = Vec::expand(0.0f);
+        std::fill(inputWindow.begin(), inputWindow.end(), 0.0f);
+        std::fill(inputSpectra.begin(), inputSpectra.end(), zero);
+        inputPosition = 0;
+        newestSpectrum = 0;
+    }
+
+    bool isPrepared() const noexcept { return fft != nullptr; }
+    int getBlockSize() const noexcept { return blockSize; }
+
+    // Convolves numSamples of input into output (which may be the same buffer)
+    void process(const float* input, float* output, int numSamples) noexcept
+    {
+        jassert(isPrepared());
+
+        int done = 0;
+        while (done < numSamples) {
+            const int num = juce::jmin(numSamples - done, blockSize - inputPosition);
+            std::copy(input + done, input + done + num, inputWindow.begin() + blockSize + inputPosition);
+
+            // The older partitions only change once per block
+            if (inputPosition == 0) {
+                std::fill(tailSpectrum.begin(), tailSpectrum.end(), Vec::expand(0.0f));
+
+                for (int p = 1; p < numPartitions; ++p) {
+                    const int index = (newestSpectrum - (p - 1) + numPartitions) % numPartitions;
+                    multiplyAccumulate(tailSpectrum.data(), partition(inputSpectra, index), partition(impulseSpectra, p));
+                }
+            }
+
+            std::copy(inputWindow.begin(), inputWindow.end(), fftBuffer.begin());
+            fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+            splitSpectrum(currentSpectrum.data());
+
+            std::copy(tailSpectrum.begin(), tailSpectrum.end(), outputSpectrum.begin());
+            multiplyAccumulate(outputSpectrum.data(), currentSpectrum.data(), partition(impulseSpectra, 0));
+
+            mergeSpectrum(outputSpectrum.data());
+            fft->performRealOnlyInverseTransform(fftBuffer.data());
+
+            // Overlap-save: the second half of the window is alias-free
+            std::copy(fftBuffer.begin() + blockSize + inputPosition,
+                      fftBuffer.begin() + blockSize + inputPosition + num,
+                      output + done);
+
+            inputPosition += num;
+            done += num;
+
+            if (inputPosition == blockSize) {
+                newestSpectrum = (newestSpectrum + 1) % numPartitions;
+                std::copy(currentSpectrum.begin(), currentSpectrum.end(), partition(inputSpectra, newestSpectrum));
+
+                std::copy(inputWindow.begin() + blockSize, inputWindow.end(), inputWindow.begin());
+                std::fill(inputWindow.begin() + blockSize, inputWindow.end(), 0.0f);
+                inputPosition = 0;
+            }
+        }
+    }
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanesPerVec = (int) Vec::SIMDNumElements;
+
+    // One spectrum is numVecs registers of real parts followed by numVecs of imaginary parts
+    int spectrumSize() const noexcept { return 2 * numVecs; }
+
+    Vec* partition(std::vector<Vec>& spectra, int index) noexcept
+    {
+        return spectra.data() + index * spectrumSize();
+    }
+
+    static float* lanes(Vec* v) noexcept { return reinterpret_cast<float*>(v); }
+
+    // Interleaved FFT output (bins 0..blockSize) -> split real / imaginary
+    void splitSpectrum(Vec* dest) noexcept
+    {
+        float* re = lanes(dest);
+        float* im = lanes(dest + numVecs);
+
+        for (int k = 0; k <= blockSize; ++k) {
+            re[k] = fftBuffer[(size_t) (2 * k)];
+            im[k] = fftBuffer[(size_t) (2 * k + 1)];
+        }
+    }
+
+    // Split -> interleaved, with the conjugate-symmetric upper half filled in
+    // so any FFT backend's inverse sees a complete spectrum
+    void mergeSpectrum(Vec* src) noexcept
+    {
+        const float* re = lanes(src);
+        const float* im = lanes(src + numVecs);
+
+        for (int k = 0; k <= blockSize; ++k) {
+            fftBuffer[(size_t) (2 * k)] = re[k];
+            fftBuffer[(size_t) (2 * k + 1)] = im[k];
+        }
+
+        for (int k = 1; k < blockSize; ++k) {
+            fftBuffer[(size_t) (2 * (fftSize - k))] = re[k];
+            fftBuffer[(size_t) (2 * (fftSize - k) + 1)] = -im[k];
+        }
+    }
+
+    void multiplyAccumulate(Vec* acc, const Vec* x, const Vec* h) const noexcept
+    {
+        Vec* accRe = acc;
+        Vec* accIm = acc + numVecs;
+        const Vec* xRe = x;
+        const Vec* xIm = x + numVecs;
+        const Vec* hRe = h;
+        const Vec* hIm = h + numVecs;
+
+        for (int k = 0; k < numVecs; ++k) {
+            accRe[k] += xRe[k] * hRe[k] - xIm[k] * hIm[k];
+            accIm[k] += xRe[k] * hIm[k] + xIm[k] * hRe[k];
+        }
+    }
+
+    //==============================================================================
+    std::unique_ptr<juce::dsp::FFT> fft;
+    int blockSize = 0, fftSize = 0, numVecs = 0, numPartitions = 0;
+    int inputPosition = 0, newestSpectrum = 0;
+
+    std::vector<float> fftBuffer, inputWindow;
+    std::vector<Vec> impulseSpectra, inputSpectra;
+    std::vector<Vec> currentSpectrum, tailSpectrum, outputSpectrum;
+
+    JUCE_LEAK_DETECTOR(UniformConvolver)
+};
+
+//==============================================================================
+/**
+    Stereo impulse-response reverb with the same interface and gain staging as
+    the algorithmic tanks. A stereo IR convolves left with its first channel
+    and right with its second. A mono IR is used for both sides.
+
+    Long IRs are split non-uniformly into two stages:
+
+    - the head, IR[0, 2L), runs on the audio thread with block-size partitions
+      and zero latency;
+    - the tail, IR[2L, end), runs on a worker thread with partition size L.
+
+    A tail block can only start once its L input samples have arrived. Because
+    the tail starts 2L samples into the IR, its output is not needed until L
+    samples after that, which gives the worker a full L samples of deadline.
+    L is chosen to balance the head cost (about 2L / blockSize partitions per
+    sample) against the tail cost (about length / L). Short IRs run entirely
+    in the head and don't start the thread.
+
+    The audio thread only publishes the submitted block count through an
+    atomic; it never signals the worker, since waking a thread can take a
+    lock. The worker polls it a few times per tail block instead.
+*/
+class ConvolutionReverb : private juce::Thread
+{
+public:
+    struct Parameters
+    {
+        float wetLevel = 0.33f;
+        float dryLevel = 0.4f;
+        float width = 1.0f;
+    };
+
+    ConvolutionReverb() : juce::Thread("ElouReverb IR tail") {}
+
+    ~ConvolutionReverb() override
+    {
+        stopThread(2000);
+    }
+
+    // Builds the partitions for an IR that is already at sampleRate and starts
+    // the tail thread if needed. Allocates, so call this off the audio thread.
+    void prepare(const juce::AudioBuffer<float>& impulse, double sampleRate, int maxBlockSize)
+    {
+        jassert(impulse.getNumChannels() > 0 && impulse.getNumSamples() > 0);
+        stopThread(2000);
+
+        // Normalise the IR energy so loudness doesn't depend on how the file was recorded
+        const int length = impulse.getNumSamples();
+        impulseLength = length;
+        const int numIrChannels = juce::jmin(2, impulse.getNumChannels());
+        double energy = 0.0;
+        for (int channel = 0; channel < numIrChannels; ++channel)
+            for (int i = 0; i < length; ++i)
+                energy += juce::square((double) impulse.getSample(channel, i));
+
+        const float normalisation = energy > 0.0 ? (float) std::sqrt(targetEnergy * numIrChannels / energy) : 0.0f;
+
+        const int headBlockSize = juce::nextPowerOfTwo(juce::jlimit(32, 8192, maxBlockSize));
+        tailBlockSize = chooseTailBlockSize(length, headBlockSize);
+        headLength = tailBlockSize > 0 ? 2 * tailBlockSize : length;
+        pollIntervalMs = juce::jlimit(1, 20, (int) (tailBlockSize * 250.0 / sampleRate));
+
+        std::vector<float> scaled((size_t) length);
+        for (int side = 0; side < 2; ++side) {
+            const float* src = impulse.getReadPointer(juce::jmin(side, numIrChannels - 1));
+            for (int i = 0; i < length; ++i)
+                scaled[(size_t) i] = src[i] * normalisation;
+
+            heads[side].prepare(scaled.data(), headLength, headBlockSize);
+
+            if (tailBlockSize > 0) {
+                tails[side].prepare(scaled.data() + headLength, length - headLength, tailBlockSize);
+                tailInput[side].assign((size_t) (tailRingBlocks * tailBlockSize), 0.0f);
+                tailOutput[side].assign((size_t) (tailRingBlocks * tailBlockSize), 0.0f);
+            }
+        }
+
+        wetLeft.assign((size_t) headBlockSize, 0.0f);
+        wetRight.assign((size_t) headBlockSize, 0.0f);
+
+        const double smoothTime = 0.01;
+        dryGain.reset(sampleRate, smoothTime);
+        wetGain1.reset(sampleRate, smoothTime);
+        wetGain2.reset(sampleRate, smoothTime);
+
+        samplePosition = 0;
+        submittedBlocks.store(0);
+        completedBlocks.store(0);
+        resetBlock.store(0);
+
+        if (tailBlockSize > 0)
+            startThread(juce::Thread::Priority::high);
+    }
+
+    void setParameters(const Parameters& newParams) noexcept
+    {
+        const float wetScaleFactor = 3.0f;
+        const float dryScaleFactor = 2.0f;
+
+        const float wet = newParams.wetLevel * wetScaleFactor;
+        dryGain.setTargetValue(newParams.dryLevel * dryScaleFactor);
+        wetGain1.setTargetValue(0.5f * wet * (1.0f + newParams.width));
+        wetGain2.setTargetValue(0.5f * wet * (1.0f - newParams.width));
+    }
+
+    // Audio thread. The tail block being filled becomes the first one after
+    // the reset: what it already holds is zeroed, the worker clears its own
+    // state before computing it, and tail output for earlier blocks is ignored.
+    void reset() noexcept
+    {
+        for (auto& head : heads)
+            head.reset();
+
+        if (tailBlockSize > 0) {
+            // The worker only reads submitted blocks, so this one is still ours
+            const juce::int64 block = samplePosition / tailBlockSize;
+            const int start = (int) ((block * tailBlockSize) % (tailRingBlocks * tailBlockSize));
+            const int filled = (int) (samplePosition % tailBlockSize);
+
+            for (auto& input : tailInput)
+                std::fill(input.begin() + start, input.begin() + start + filled, 0.0f);
+
+            resetBlock.store(block);
+        }
+    }
+
+    // Longest an input sample keeps reaching the output
+    int getImpulseLength() const noexcept { return impulseLength; }
+
+    // Number of tail blocks the worker delivered too late (diagnostics)
+    int getTailUnderruns() const noexcept { return tailUnderruns.load(); }
+
+    void processStereo(float* left, float* right, int numSamples) noexcept
+    {
+        const int chunkSize = (int) wetLeft.size();
+
+        for (int start = 0; start < numSamples; start += chunkSize) {
+            const int num = juce::jmin(chunkSize, numSamples - start);
+            float* l = left + start;
+            float* r = right + start;
+
+            heads[0].process(l, wetLeft.data(), num);
+            heads[1].process(r, wetRight.data(), num);
+
+            if (tailBlockSize > 0)
+                exchangeWithTail(l, r, num);
+
+            for (int i = 0; i < num; ++i) {
+                const float dry = dryGain.getNextValue();
+                const float wet1 = wetGain1.getNextValue();
+                const float wet2 = wetGain2.getNextValue();
+
+                const float dryLeft = l[i];
+                const float dryRight = r[i];
+                l[i] = wetLeft[(size_t) i] * wet1 + wetRight[(size_t) i] * wet2 + dryLeft * dry;
+                r[i] = wetRight[(size_t) i] * wet1 + wetLeft[(size_t) i] * wet2 + dryRight * dry;
+            }
+        }
+    }
+
+    void processMono(float* samples, int numSamples) noexcept
+    {
+        const int chunkSize = (int) wetLeft.size();
+
+        for (int start = 0; start < numSamples; start += chunkSize) {
+            const int num = juce::jmin(chunkSize, numSamples - start);
+            float* s = samples + start;
+
+            heads[0].process(s, wetLeft.data(), num);
+
+            if (tailBlockSize > 0)
+                exchangeWithTail(s, nullptr, num);
+
+            for (int i = 0; i < num; ++i) {
+                const float dry = dryGain.getNextValue();
+                const float wet1 = wetGain1.getNextValue();
+                s[i] = wetLeft[(size_t) i] * wet1 + s[i] * dry;
+            }
+        }
+    }
+
+private:
+    // Per-channel IR energy after normalisation; puts the wet level in the
+    // same region as the algorithmic tanks
+    static constexpr double targetEnergy = 0.15;
+
+    // Blocks of slack in the tail rings before the worker counts as hopelessly late
+    static constexpr int tailRingBlocks = 4;
+
+    static int chooseTailBlockSize(int length, int headBlockSize) noexcept
+    {
+        const int balanced = juce::nextPowerOfTwo((int) std::sqrt(0.5 * length * headBlockSize));
+        const int tailBlock = juce::jlimit(8 * headBlockSize, 16384, balanced);
+        return length > 2 * tailBlock ? tailBlock : 0;
+    }
+
+    //==============================================================================
+    // Audio thread: queues input for the tail and adds in whatever tail output
+    // is due. right may be null in mono.
+    void exchangeWithTail(const float* left, const float* right, int num) noexcept
+    {
+        const int ringSize = tailRingBlocks * tailBlockSize;
+        int done = 0;
+
+        while (done < num) {
+            // Stay inside one tail block so both ring spans are contiguous
+            const int offsetInBlock = (int) (samplePosition % tailBlockSize);
+            const int n = juce::jmin(num - done, tailBlockSize - offsetInBlock);
+            const int writeIndex = (int) (samplePosition % ringSize);
+
+            std::copy(left + done, left + done + n, tailInput[0].begin() + writeIndex);
+            if (right != nullptr)
+                std::copy(right + done, right + done + n, tailInput[1].begin() + writeIndex);
+            else
+                std::fill(tailInput[1].begin() + writeIndex, tailInput[1].begin() + writeIndex + n, 0.0f);
+
+            // The tail's output for input block b lands 2L samples later (see class comment)
+            const juce::int64 delayed = samplePosition - headLength;
+            if (delayed >= 0) {
+                const juce::int64 block = delayed / tailBlockSize;
+                const int readIndex = (int) (delayed % ringSize);
+
+                if (block < completedBlocks.load(std::memory_order_acquire)) {
+                    if (block >= resetBlock.load()) {
+                        juce::FloatVectorOperations::add(wetLeft.data() + done, tailOutput[0].data() + readIndex, n);
+                        if (right != nullptr)
+                            juce::FloatVectorOperations::add(wetRight.data() + done, tailOutput[1].data() + readIndex, n);
+                    }
+                } else if (offsetInBlock == 0) {
+                    tailUnderruns.fetch_add(1);
+                }
+            }
+
+            samplePosition += n;
+            done += n;
+
+            if (samplePosition % tailBlockSize == 0)
+                submittedBlocks.store(samplePosition / tailBlockSize, std::memory_order_release);
+        }
+    }
+
+    // Worker thread: convolves each submitted input block with the IR tail
+    void run() override
+    {
+        const int ringSize = tailRingBlocks * tailBlockSize;
+        juce::int64 tailResetBlock = 0;
+
+        while (! threadShouldExit()) {
+            const juce::int64 submitted = submittedBlocks.load(std::memory_order_acquire);
+            juce::int64 block = completedBlocks.load();
+
+            if (block >= submitted) {
+                wait(pollIntervalMs);
+                continue;
+            }
+
+            // Too far behind: the input ring has been overwritten, so silence
+            // the blocks that were skipped and start over
+            if (submitted - block >= tailRingBlocks) {
+                for (auto& output : tailOutput)
+                    std::fill(output.begin(), output.end(), 0.0f);
+
+                block = submitted - 1;
+                tailResetBlock = -1;
+                tailUnderruns.fetch_add(1);
+            }
+
+            const juce::int64 requestedReset = resetBlock.load();
+            if (tailResetBlock != requestedReset && block >= requestedReset) {
+                for (auto& tail : tails)
+                    tail.reset();
+                tailResetBlock = requestedReset;
+            }
+
+            const int index = (int) ((block * tailBlockSize) % ringSize);
+            for (int side = 0; side < 2; ++side)
+                tails[side].process(tailInput[side].data() + index, tailOutput[side].data() + index, tailBlockSize);
+
+            completedBlocks.store(block + 1, std::memory_order_release);
+        }
+    }
+
+    //==============================================================================
+    UniformConvolver heads[2];
+    std::vector<float> wetLeft, wetRight;
+    int impulseLength = 0;
+    juce::SmoothedValue<float> dryGain, wetGain1, wetGain2;
+
+    // Tail stage (tailBlockSize == 0 when the IR fits in the head)
+    UniformConvolver tails[2];
+    std::vector<float> tailInput[2], tailOutput[2];
+    int tailBlockSize = 0;
+    int headLength = 0;
+    int pollIntervalMs = 1;     // A quarter of a tail block, at most
+
+    juce::int64 samplePosition = 0;                    // audio thread only
+    std::atomic<juce::int64> submittedBlocks { 0 };    // written by the audio thread
+    std::atomic<juce::int64> completedBlocks { 0 };    // written by the worker
+    std::atomic<juce::int64> resetBlock { 0 };         // first block after the last reset
+    std::atomic<int> tailUnderruns { 0 };
+
+    JUCE_LEAK_DETECTOR(ConvolutionReverb)
+};
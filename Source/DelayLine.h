@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    DelayLine.h
+
+    Ring-buffer delay line that the reverb tanks read and write a sub-block
+    at a time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Fixed-length delay line for sub-block processing. read() returns the next
+    num delayed samples and write() overwrites the same span and advances.
+    num must not exceed the delay length, so nothing written in a sub-block is
+    read back within that sub-block.
+
+    SampleType is float or double, matching the processing precision.
+
+    The stride arguments let a tank gather several lines into one transposed
+    scratch block (one row per sample, one SIMD lane per line).
+*/
+template <typename SampleType>
+struct BlockDelayLine
+{
+    // Allocates, so call this from prepareToPlay
+    void setSize(int newSize)
+    {
+        size = juce::jmax(1, newSize);
+        buffer.assign((size_t) size, SampleType());
+        index = 0;
+    }
+
+    void clear() noexcept
+    {
+        std::fill(buffer.begin(), buffer.end(), SampleType());
+    }
+
+    void read(SampleType* dest, int stride, int num) const noexcept
+    {
+        jassert(num <= size);
+
+        const int first = juce::jmin(num, size - index);
+        const SampleType* src = buffer.data();
+
+        for (int i = 0; i < first; ++i)
+            dest[i * stride] = src[index + i];
+        for (int i = first; i < num; ++i)
+            dest[i * stride] = src[i - first];
+    }
+
+    void write(const SampleType* src, int stride, int num) noexcept
+    {
+        jassert(num <= size);
+
+        const int first = juce::jmin(num, size - index);
+        SampleType* dest = buffer.data();
+
+        for (int i = 0; i < first; ++i)
+            dest[index + i] = src[i * stride];
+        for (int i = first; i < num; ++i)
+            dest[i - first] = src[i * stride];
+
+        index = (index + num) % size;
+    }
+
+    std::vector<SampleType> buffer;
+    int size = 1;
+    int index = 0;
+};
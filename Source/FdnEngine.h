@@ -0,0 +1,441 @@
+/*
+  ==============================================================================
+
+    FdnEngine.h
+
+    Feedback delay network reverb tank, selectable instead of Freeverb.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DelayLine.h"
+
+//==============================================================================
+/**
+    Feedback delay network with numLines delay lines, one per SIMD lane.
+
+    - Delay lengths are spread geometrically between ~23 and ~73 ms. Each is
+      rounded to a distinct prime at the current sample rate, so all lengths
+      are mutually prime.
+    - The feedback matrix is an orthonormal Hadamard matrix. The multiply is
+      done as a broadcast multiply-add over matrix columns, so it is all
+      vector ops.
+    - Each line has a one-pole absorption filter. It gives an exact RT60 at DC
+      (decayTime) and a shorter RT60 at Nyquist (set by damping). Unlike
+      Freeverb's capped feedback, this covers the whole 0.1-25 s range.
+
+    - processMultichannel() gives each output channel its own Hadamard row
+      as output tap, so every channel of a surround bus gets a decorrelated
+      late field from the same network. The taps are packed one output
+      channel per lane and accumulated alongside the feedback mix, so a
+      channel costs a fraction of a register per line, not a pass of its own.
+
+    Gain staging matches FreeverbEngine (dry x2), so switching algorithms keeps
+    the dry level and roughly the wet loudness. SampleType is float or double;
+    the line gains are computed in double either way.
+*/
+template <typename SampleType, int numLines>
+class FdnEngine
+{
+public:
+    struct Parameters
+    {
+        float decayTime = 2.0f;  // RT60 at low frequencies, in seconds
+        float damping = 0.5f;    // 0 = flat decay, 1 = highs decay 20x faster
+        float wetLevel = 0.33f;
+        float dryLevel = 0.4f;
+        float width = 1.0f;
+    };
+
+    FdnEngine()
+    {
+        buildMatrices();
+        setSampleRate(44100.0);
+        setParameters(Parameters());
+    }
+
+    const Parameters& getParameters() const noexcept { return parameters; }
+
+    // Longest a sample can stay in the network before it reaches the output
+    int getLongestDelayInSamples() const noexcept { return lines[numLines - 1].size; }
+
+    void setParameters(const Parameters& newParams)
+    {
+        const float wetScaleFactor = 3.0f;
+        const float dryScaleFactor = 2.0f;
+
+        const float wet = newParams.wetLevel * wetScaleFactor;
+        dryGain.setTargetValue(static_cast<SampleType>(newParams.dryLevel * dryScaleFactor));
+        wetGain1.setTargetValue(static_cast<SampleType>(0.5f * wet * (1.0f + newParams.width)));
+        wetGain2.setTargetValue(static_cast<SampleType>(0.5f * wet * (1.0f - newParams.width)));
+
+        const bool decayChanged = newParams.decayTime != parameters.decayTime
+                               || newParams.damping != parameters.damping;
+        parameters = newParams;
+
+        if (decayChanged)
+            updateDecay();
+    }
+
+    // Allocates the delay lines, so call this from prepareToPlay, not the audio thread
+    void setSampleRate(double newSampleRate)
+    {
+        jassert(newSampleRate > 0);
+        sampleRate = newSampleRate;
+
+        const double minDelayMs = 23.0;
+        const double maxDelayMs = 73.0;
+        int previousLength = 0;
+        subBlockSize = maxSubBlockSize;
+
+        for (int i = 0; i < numLines; ++i) {
+            const double ms = minDelayMs * std::pow(maxDelayMs / minDelayMs, i / (double) (numLines - 1));
+            const int length = nextPrime(juce::jmax(previousLength + 1, juce::roundToInt(ms * 0.001 * sampleRate)));
+
+            lines[i].setSize(length);
+            previousLength = length;
+            subBlockSize = juce::jmin(subBlockSize, length);
+        }
+
+        const double smoothTime = 0.01;
+        dryGain.reset(sampleRate, smoothTime);
+        wetGain1.reset(sampleRate, smoothTime);
+        wetGain2.reset(sampleRate, smoothTime);
+
+        reset();
+        updateDecay();
+    }
+
+    void reset()
+    {
+        for (auto& line : lines)
+            line.clear();
+
+        for (auto& state : filterState)
+            state = Vec::expand(SampleType());
+    }
+
+    void processStereo(SampleType* left, SampleType* right, int numSamples) noexcept
+    {
+        jassert(left != nullptr && right != nullptr);
+
+        for (int start = 0; start < numSamples; start += subBlockSize) {
+            const int num = juce::jmin(subBlockSize, numSamples - start);
+            SampleType* l = left + start;
+            SampleType* r = right + start;
+
+            for (int i = 0; i < num; ++i)
+                input[i] = (l[i] + r[i]) * inputGain;
+
+            processNetwork(num);
+
+            for (int i = 0; i < num; ++i) {
+                const SampleType dry = dryGain.getNextValue();
+                const SampleType wet1 = wetGain1.getNextValue();
+                const SampleType wet2 = wetGain2.getNextValue();
+
+                const SampleType dryLeft = l[i];
+                const SampleType dryRight = r[i];
+                l[i] = wetLeft[i] * wet1 + wetRight[i] * wet2 + dryLeft * dry;
+                r[i] = wetRight[i] * wet1 + wetLeft[i] * wet2 + dryRight * dry;
+            }
+        }
+    }
+
+    // Mono in, stereo out: left holds the input and right is overwritten.
+    // One input drives the whole tank, with the same level as a mono signal
+    // duplicated to both channels of processStereo().
+    void processMonoToStereo(SampleType* left, SampleType* right, int numSamples) noexcept
+    {
+        jassert(left != nullptr && right != nullptr);
+
+        for (int start = 0; start < numSamples; start += subBlockSize) {
+            const int num = juce::jmin(subBlockSize, numSamples - start);
+            SampleType* l = left + start;
+            SampleType* r = right + start;
+
+            for (int i = 0; i < num; ++i)
+                input[i] = l[i] * (2 * inputGain);
+
+            processNetwork(num);
+
+            for (int i = 0; i < num; ++i) {
+                const SampleType dry = dryGain.getNextValue();
+                const SampleType wet1 = wetGain1.getNextValue();
+                const SampleType wet2 = wetGain2.getNextValue();
+
+                const SampleType drySample = l[i];
+                l[i] = wetLeft[i] * wet1 + wetRight[i] * wet2 + drySample * dry;
+                r[i] = wetRight[i] * wet1 + wetLeft[i] * wet2 + drySample * dry;
+            }
+        }
+    }
+
+    void processMono(SampleType* samples, int numSamples) noexcept
+    {
+        jassert(samples != nullptr);
+
+        for (int start = 0; start < numSamples; start += subBlockSize) {
+            const int num = juce::jmin(subBlockSize, numSamples - start);
+            SampleType* s = samples + start;
+
+            for (int i = 0; i < num; ++i)
+                input[i] = s[i] * (2 * inputGain);
+
+            processNetwork(num);
+
+            for (int i = 0; i < num; ++i) {
+                const SampleType dry = dryGain.getNextValue();
+                const SampleType wet1 = wetGain1.getNextValue();
+                s[i] = wetLeft[i] * wet1 + s[i] * dry;
+            }
+        }
+    }
+
+    // Outputs of processMultichannel() beyond this are left dry
+    static constexpr int maxOutputChannels = juce::jmin(12, numLines - 2);
+
+    // The input is the sum of every channel except skipChannel (the LFE, or
+    // -1), which gets no wet signal either
+    void processMultichannel(SampleType* const* channels, int numChannels, int skipChannel, int numSamples) noexcept
+    {
+        jassert(channels != nullptr && numChannels <= maxOutputChannels);
+
+        const int numWetChannels = juce::jmin(numChannels, maxOutputChannels);
+        const int numInputs = numWetChannels - (juce::isPositiveAndBelow(skipChannel, numWetChannels) ? 1 : 0);
+        const SampleType gain = numInputs > 0 ? 2 * inputGain / (SampleType) numInputs : SampleType();
+
+        for (int start = 0; start < numSamples; start += subBlockSize) {
+            const int num = juce::jmin(subBlockSize, numSamples - start);
+
+            for (int i = 0; i < num; ++i)
+                input[i] = SampleType();
+
+            for (int channel = 0; channel < numWetChannels; ++channel)
+                if (channel != skipChannel)
+                    for (int i = 0; i < num; ++i)
+                        input[i] += channels[channel][start + i];
+
+            for (int i = 0; i < num; ++i)
+                input[i] *= gain;
+
+            processNetwork<true>(num);
+
+            for (int i = 0; i < num; ++i) {
+                const SampleType dry = dryGain.getNextValue();
+                const SampleType wet = wetGain1.getNextValue();
+                wetGain2.getNextValue();
+
+                const SampleType* frame = wetFrames + i * maxOutputLanes;
+
+                for (int channel = 0; channel < numWetChannels; ++channel) {
+                    SampleType& sample = channels[channel][start + i];
+                    sample = (channel != skipChannel ? frame[channel] * wet : SampleType()) + sample * dry;
+                }
+            }
+        }
+    }
+
+private:
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+
+    static constexpr int lanesPerVec = (int) Vec::SIMDNumElements;
+    static constexpr int numVecs = numLines / lanesPerVec;
+    static constexpr int maxSubBlockSize = 64;
+    static constexpr int numOutputVecs = (maxOutputChannels + lanesPerVec - 1) / lanesPerVec;
+    static constexpr int maxOutputLanes = numOutputVecs * lanesPerVec;
+
+    // Roughly matches FreeverbEngine's wet loudness at the default decay. The
+    // wet level of a smaller network rises by about 3 dB per halving of the
+    // line count, so the input is scaled to keep it (16 lines: 0.5).
+    const SampleType inputGain = SampleType(0.5) * std::sqrt((SampleType) numLines / SampleType(16));
+
+    static_assert(numLines >= 4 && (numLines & (numLines - 1)) == 0, "Hadamard mixing needs a power-of-two line count");
+    static_assert(numLines % lanesPerVec == 0, "delay lines must fill whole SIMD registers");
+
+    static int nextPrime(int n) noexcept
+    {
+        auto isPrime = [](int x) {
+            if (x < 2) return false;
+            for (int d = 2; d * d <= x; ++d)
+                if (x % d == 0) return false;
+            return true;
+        };
+
+        while (! isPrime(n))
+            ++n;
+        return n;
+    }
+
+    // Sign of entry (row, column) of the Sylvester Hadamard matrix
+    static SampleType hadamardSign(int row, int column) noexcept
+    {
+        int bits = row & column;
+        int parity = 0;
+        while (bits != 0) {
+            parity ^= 1;
+            bits &= bits - 1;
+        }
+        return parity != 0 ? SampleType(-1) : SampleType(1);
+    }
+
+    void buildMatrices() noexcept
+    {
+        alignas(Vec::SIMDRegisterSize) SampleType lanes[numLines];
+        const SampleType scale = SampleType(1) / std::sqrt((SampleType) numLines);
+
+        for (int column = 0; column < numLines; ++column) {
+            for (int row = 0; row < numLines; ++row)
+                lanes[row] = hadamardSign(row, column) * scale;
+            for (int v = 0; v < numVecs; ++v)
+                mixColumns[column][v] = Vec::fromRawArray(lanes + v * lanesPerVec);
+        }
+
+        // Two orthogonal Hadamard rows give decorrelated left/right taps, a
+        // third spreads the input across the lines with mixed signs
+        auto loadRow = [&](Vec* dest, int row) {
+            for (int i = 0; i < numLines; ++i)
+                lanes[i] = hadamardSign(row, i) * scale;
+            for (int v = 0; v < numVecs; ++v)
+                dest[v] = Vec::fromRawArray(lanes + v * lanesPerVec);
+        };
+
+        loadRow(outputTapsLeft, 1);
+        loadRow(outputTapsRight, 2);
+        loadRow(inputTaps, numLines - 1);
+
+        // Multichannel taps by line: output channel c reads Hadamard row c + 1
+        // (so the first two match the stereo taps), one channel per lane
+        alignas(Vec::SIMDRegisterSize) SampleType taps[maxOutputLanes];
+
+        for (int column = 0; column < numLines; ++column) {
+            for (int channel = 0; channel < maxOutputLanes; ++channel)
+                taps[channel] = channel < maxOutputChannels ? hadamardSign(channel + 1, column) * scale : SampleType();
+            for (int v = 0; v < numOutputVecs; ++v)
+                outputColumns[column][v] = Vec::fromRawArray(taps + v * lanesPerVec);
+        }
+    }
+
+    void updateDecay() noexcept
+    {
+        alignas(Vec::SIMDRegisterSize) SampleType gains[numLines];
+        alignas(Vec::SIMDRegisterSize) SampleType poles[numLines];
+
+        const double decayLow = juce::jmax(0.01, (double) parameters.decayTime);
+        const double decayHigh = decayLow * (1.0 - 0.95 * juce::jlimit(0.0f, 1.0f, parameters.damping));
+
+        for (int i = 0; i < numLines; ++i) {
+            const double length = (double) lines[i].size;
+            const double gainLow = std::pow(10.0, -3.0 * length / (decayLow * sampleRate));
+            const double gainHigh = std::pow(10.0, -3.0 * length / (decayHigh * sampleRate));
+
+            // One-pole g(1 - b) / (1 - b z^-1): DC gain g, Nyquist gain g(1 - b) / (1 + b).
+            // Short, heavily damped decays put b within float precision of 1,
+            // where the filter turns into an integrator that holds DC forever.
+            // At 0.999 the highs are already down by 66 dB per pass.
+            const double ratio = gainHigh / gainLow;
+            const double pole = juce::jmin((1.0 - ratio) / (1.0 + ratio), 0.999);
+
+            gains[i] = (SampleType) (gainLow * (1.0 - pole));
+            poles[i] = (SampleType) pole;
+        }
+
+        for (int v = 0; v < numVecs; ++v) {
+            lineGains[v] = Vec::fromRawArray(gains + v * lanesPerVec);
+            linePoles[v] = Vec::fromRawArray(poles + v * lanesPerVec);
+        }
+    }
+
+    //==============================================================================
+    // Runs num samples through the network. The wet output goes to wetLeft /
+    // wetRight, or to wetFrames (one row of channels per sample) when
+    // multichannel.
+    template <bool multichannel = false>
+    void processNetwork(int num) noexcept
+    {
+        for (int line = 0; line < numLines; ++line)
+            lines[line].read(lineScratch + line, numLines, num);
+
+        alignas(Vec::SIMDRegisterSize) SampleType filtered[numLines];
+
+        for (int i = 0; i < num; ++i) {
+            SampleType* row = lineScratch + i * numLines;
+            auto sumLeft = Vec::expand(SampleType());
+            auto sumRight = Vec::expand(SampleType());
+
+            for (int v = 0; v < numVecs; ++v) {
+                const auto delayed = Vec::fromRawArray(row + v * lanesPerVec);
+                filterState[v] = delayed * lineGains[v] + filterState[v] * linePoles[v];
+                filterState[v].copyToRawArray(filtered + v * lanesPerVec);
+
+                if constexpr (! multichannel) {
+                    sumLeft += filterState[v] * outputTapsLeft[v];
+                    sumRight += filterState[v] * outputTapsRight[v];
+                }
+            }
+
+            if constexpr (! multichannel) {
+                wetLeft[i] = sumLeft.sum();
+                wetRight[i] = sumRight.sum();
+            }
+
+            // Feedback: Hadamard mix of the filtered lines plus the new input.
+            // The multichannel taps share the same broadcast of each line.
+            const auto inputVec = Vec::expand(input[i]);
+            Vec mixed[numVecs];
+            Vec wet[numOutputVecs];
+
+            for (int v = 0; v < numVecs; ++v)
+                mixed[v] = inputVec * inputTaps[v];
+
+            if constexpr (multichannel)
+                for (auto& w : wet)
+                    w = Vec::expand(SampleType());
+
+            for (int column = 0; column < numLines; ++column) {
+                const auto value = Vec::expand(filtered[column]);
+                for (int v = 0; v < numVecs; ++v)
+                    mixed[v] += mixColumns[column][v] * value;
+
+                if constexpr (multichannel)
+                    for (int v = 0; v < numOutputVecs; ++v)
+                        wet[v] += outputColumns[column][v] * value;
+            }
+
+            for (int v = 0; v < numVecs; ++v)
+                mixed[v].copyToRawArray(row + v * lanesPerVec);
+
+            if constexpr (multichannel)
+                for (int v = 0; v < numOutputVecs; ++v)
+                    wet[v].copyToRawArray(wetFrames + i * maxOutputLanes + v * lanesPerVec);
+        }
+
+        for (int line = 0; line < numLines; ++line)
+            lines[line].write(lineScratch + line, numLines, num);
+    }
+
+    //==============================================================================
+    BlockDelayLine<SampleType> lines[numLines];
+
+    Vec mixColumns[numLines][numVecs];
+    Vec inputTaps[numVecs], outputTapsLeft[numVecs], outputTapsRight[numVecs];
+    Vec outputColumns[numLines][numOutputVecs];
+    Vec lineGains[numVecs], linePoles[numVecs], filterState[numVecs];
+
+    juce::SmoothedValue<SampleType> dryGain, wetGain1, wetGain2;
+
+    Parameters parameters;
+    double sampleRate = 44100.0;
+    int subBlockSize = maxSubBlockSize;
+
+    alignas(Vec::SIMDRegisterSize) SampleType lineScratch[maxSubBlockSize * numLines];
+    SampleType input[maxSubBlockSize];
+    SampleType wetLeft[maxSubBlockSize];
+    SampleType wetRight[maxSubBlockSize];
+    alignas(Vec::SIMDRegisterSize) SampleType wetFrames[maxSubBlockSize * maxOutputLanes];
+
+    JUCE_LEAK_DETECTOR(FdnEngine)
+};
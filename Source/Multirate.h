@@ -0,0 +1,353 @@
+/*
+  ==============================================================================
+
+    Multirate.h
+
+    Half-band decimation and interpolation, so the reverb tank can run at a
+    half or a quarter of the host sample rate.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Linear-phase half-band FIR (Kaiser-windowed sinc, 31 taps). Flat to 0.18
+    of its rate, at least 70 dB down from 0.33. Every other tap of a half-band filter is zero and the centre
+    tap is 0.5, so only the numPairs symmetric odd-offset taps are stored.
+
+    The decimator and interpolator below run one channel each and stream:
+    they keep their history across calls of any length.
+*/
+struct HalfBandCoefficients
+{
+    static constexpr int numPairs = 8;
+    static constexpr int numTaps = 4 * numPairs - 1;
+    static constexpr int centre = numTaps / 2;
+
+    // Tap at offset centre +- (2 * j + 1), for j in [0, numPairs)
+    static const double* get()
+    {
+        static const auto taps = [] {
+            std::array<double, numPairs> result {};
+            const double beta = 7.0;
+            double sum = 0.0;
+
+            for (int j = 0; j < numPairs; ++j) {
+                const int offset = 2 * j + 1;
+                const double ratio = (double) offset / (double) centre;
+                const double window = besselI0(beta * std::sqrt(1.0 - ratio * ratio)) / besselI0(beta);
+                const double sinc = ((j % 2 == 0) ? 1.0 : -1.0) / (juce::MathConstants<double>::pi * offset);
+                result[(size_t) j] = sinc * window;
+                sum += result[(size_t) j];
+            }
+
+            // Unity gain at DC: 0.5 + 2 * sum == 1
+            for (auto& tap : result)
+                tap *= 0.25 / sum;
+
+            return result;
+        }();
+
+        return taps.data();
+    }
+
+    static double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 32; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+};
+
+//==============================================================================
+// Halves the rate of one channel. Produces an output for every second input
+// sample, carrying the odd one over to the next call.
+//
+// Polyphase form: the input is split into the samples that meet the centre
+// tap (even) and those that meet the other taps (odd). Each tap is then one
+// vector multiply-add over the whole block of outputs.
+template <typename SampleType>
+class HalfBandDecimator
+{
+public:
+    // Allocates, so call this from prepareToPlay
+    void prepare(int maxInputSamples)
+    {
+        const double* taps = HalfBandCoefficients::get();
+        for (int j = 0; j < numPairs; ++j)
+            coefficients[j] = (SampleType) taps[j];
+
+        const int maxPairs = maxInputSamples / 2 + 1;
+        even.assign((size_t) (evenHistory + maxPairs), SampleType());
+        odd.assign((size_t) (oddHistory + maxPairs), SampleType());
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::fill(even.begin(), even.end(), SampleType());
+        std::fill(odd.begin(), odd.end(), SampleType());
+        pending = SampleType();
+        hasPending = false;
+    }
+
+    // Returns the number of samples written to output
+    int process(const SampleType* input, int numSamples, SampleType* output) noexcept
+    {
+        using FVO = juce::FloatVectorOperations;
+
+        // Split into pairs, completing the one left over from the last call
+        int numOutput = 0;
+        int i = 0;
+        if (hasPending && numSamples > 0) {
+            even[(size_t) evenHistory] = pending;
+            odd[(size_t) oddHistory] = input[0];
+            numOutput = 1;
+            i = 1;
+        }
+
+        jassert((size_t) (oddHistory + numOutput + (numSamples - i) / 2) <= odd.size());
+
+        for (; i + 1 < numSamples; i += 2, ++numOutput) {
+            even[(size_t) (evenHistory + numOutput)] = input[i];
+            odd[(size_t) (oddHistory + numOutput)] = input[i + 1];
+        }
+
+        if (numSamples > 0) {
+            hasPending = i < numSamples;
+            if (hasPending)
+                pending = input[i];
+        }
+
+        if (numOutput == 0)
+            return 0;
+
+        // Output m sits on even[m] (the centre tap); its other taps are
+        // odd[m + numPairs + j] and odd[m + numPairs - 1 - j]
+        const SampleType* e = even.data();
+        const SampleType* o = odd.data();
+        FVO::copyWithMultiply(output, e, SampleType(0.5), numOutput);
+
+        for (int j = 0; j < numPairs; ++j) {
+            FVO::addWithMultiply(output, o + numPairs + j, coefficients[j], numOutput);
+            FVO::addWithMultiply(output, o + numPairs - 1 - j, coefficients[j], numOutput);
+        }
+
+        std::memmove(even.data(), e + numOutput, sizeof(SampleType) * (size_t) evenHistory);
+        std::memmove(odd.data(), o + numOutput, sizeof(SampleType) * (size_t) oddHistory);
+        return numOutput;
+    }
+
+private:
+    static constexpr int numPairs = HalfBandCoefficients::numPairs;
+
+    // Pairs of history each stream needs
+    static constexpr int evenHistory = numPairs - 1;
+    static constexpr int oddHistory = 2 * numPairs - 1;
+
+    SampleType coefficients[numPairs] {};
+    std::vector<SampleType> even, odd;
+    SampleType pending {};
+    bool hasPending = false;
+};
+
+//==============================================================================
+// Doubles the rate of one channel: each input sample yields two outputs.
+// Zero stuffing is implicit, so one output of each pair is a plain delayed
+// copy of the input (the centre tap) and only the other one is filtered,
+// one vector multiply-add per tap over the block.
+template <typename SampleType>
+class HalfBandInterpolator
+{
+public:
+    // Allocates, so call this from prepareToPlay
+    void prepare(int maxInputSamples)
+    {
+        const double* taps = HalfBandCoefficients::get();
+        for (int j = 0; j < numPairs; ++j)
+            coefficients[j] = (SampleType) (2.0 * taps[j]);
+
+        history.assign((size_t) (historyLength + maxInputSamples), SampleType());
+        filtered.assign((size_t) maxInputSamples, SampleType());
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::fill(history.begin(), history.end(), SampleType());
+    }
+
+    // Writes 2 * numSamples samples to output
+    void process(const SampleType* input, int numSamples, SampleType* output) noexcept
+    {
+        using FVO = juce::FloatVectorOperations;
+
+        jassert((size_t) numSamples <= filtered.size());
+
+        SampleType* x = history.data();
+        std::memcpy(x + historyLength, input, sizeof(SampleType) * (size_t) numSamples);
+
+        // Filtered output m uses x[m + numPairs + j] and x[m + numPairs - 1 - j];
+        // the unfiltered one is x[m + numPairs], the centre tap
+        SampleType* y = filtered.data();
+        FVO::clear(y, numSamples);
+
+        for (int j = 0; j < numPairs; ++j) {
+            FVO::addWithMultiply(y, x + numPairs + j, coefficients[j], numSamples);
+            FVO::addWithMultiply(y, x + numPairs - 1 - j, coefficients[j], numSamples);
+        }
+
+        for (int i = 0; i < numSamples; ++i) {
+            output[2 * i] = y[i];
+            output[2 * i + 1] = x[i + numPairs];
+        }
+
+        std::memmove(x, x + numSamples, sizeof(SampleType) * (size_t) historyLength);
+    }
+
+private:
+    static constexpr int numPairs = HalfBandCoefficients::numPairs;
+    static constexpr int historyLength = 2 * numPairs - 1;
+
+    SampleType coefficients[numPairs] {};
+    std::vector<SampleType> history, filtered;
+};
+
+//==============================================================================
+/**
+    Runs a reverb tank at the host rate divided by 1, 2 or 4.
+
+    process() decimates the input channels through one or two half-band
+    stages, hands the reduced-rate block to the tank, then interpolates the
+    output channels back up. The decimator only emits a sample once it has
+    'factor' inputs, so the upsampled output goes through a short FIFO that
+    starts factor - 1 samples ahead; every call then returns exactly as
+    many samples as it was given, whatever the block size.
+
+    The filters delay the wet signal by getLatencySamples().
+*/
+template <typename SampleType>
+class TankResampler
+{
+public:
+    static constexpr int maxChannels = 12;
+
+    // Allocates, so call this from prepareToPlay. A factor of 1 leaves the
+    // resampler inactive.
+    void prepare(int newFactor, int numChannels, int maxBlockSize)
+    {
+        jassert(newFactor == 1 || newFactor == 2 || newFactor == 4);
+        jassert(numChannels <= maxChannels);
+
+        factor = newFactor;
+        numStages = factor == 4 ? 2 : (factor == 2 ? 1 : 0);
+
+        // Each stage may emit one sample more than half its input, as the
+        // odd sample from the previous call completes a pair
+        int stageSize = maxBlockSize;
+        for (int stage = 0; stage < numStages; ++stage) {
+            for (int channel = 0; channel < numChannels; ++channel) {
+                decimators[stage][channel].prepare(stageSize);
+                interpolators[stage][channel].prepare(stageSize / 2 + 1);
+            }
+            stageSize = stageSize / 2 + 1;
+            stageBuffers[stage].setSize(numChannels, 2 * stageSize);
+        }
+
+        fifo.setSize(numChannels, maxBlockSize + 2 * factor);
+        reset();
+    }
+
+    bool isActive() const noexcept { return factor > 1; }
+    int getFactor() const noexcept { return factor; }
+
+    // Delay of the wet signal, in host-rate samples. The FIFO's head start
+    // cancels the decimator waiting for a full pair, so only the filters
+    // count; the second stage runs at half rate and so counts twice.
+    int getLatencySamples() const noexcept
+    {
+        const int stageDelay = 2 * HalfBandCoefficients::centre; // Decimator + interpolator
+        return numStages == 0 ? 0 : stageDelay * (factor == 4 ? 3 : 1);
+    }
+
+    void reset() noexcept
+    {
+        for (int stage = 0; stage < numStages; ++stage) {
+            for (auto& decimator : decimators[stage])
+                decimator.reset();
+            for (auto& interpolator : interpolators[stage])
+                interpolator.reset();
+        }
+
+        fifo.clear();
+        fifoCount = factor - 1;
+    }
+
+    // tank(channels, numReducedSamples) runs in place over the reduced-rate
+    // block. Input channels feed it, output channels come back from it.
+    template <typename Tank>
+    void process(SampleType* const* channels, int numInputChannels, int numOutputChannels, int numSamples,
+                 Tank&& tank) noexcept
+    {
+        jassert(isActive());
+
+        // Down
+        int numReduced = numSamples;
+        for (int stage = 0; stage < numStages; ++stage) {
+            int produced = 0;
+            for (int channel = 0; channel < numInputChannels; ++channel) {
+                const SampleType* source = stage == 0 ? channels[channel] : stageBuffers[stage - 1].getReadPointer(channel);
+                produced = decimators[stage][channel].process(source, numReduced, stageBuffers[stage].getWritePointer(channel));
+            }
+            numReduced = produced;
+        }
+
+        auto& reduced = stageBuffers[numStages - 1];
+        if (numReduced > 0)
+            tank(reduced.getArrayOfWritePointers(), numReduced);
+
+        // Up, the last stage writing straight into the FIFO
+        for (int stage = numStages - 1; stage >= 0; --stage) {
+            for (int channel = 0; channel < numOutputChannels; ++channel) {
+                SampleType* dest = stage == 0 ? fifo.getWritePointer(channel, fifoCount)
+                                              : stageBuffers[stage - 1].getWritePointer(channel);
+                interpolators[stage][channel].process(stageBuffers[stage].getReadPointer(channel), numReduced, dest);
+            }
+            numReduced *= 2;
+        }
+
+        fifoCount += numReduced;
+        jassert(fifoCount >= numSamples);
+
+        for (int channel = 0; channel < numOutputChannels; ++channel) {
+            SampleType* queued = fifo.getWritePointer(channel);
+            std::memcpy(channels[channel], queued, sizeof(SampleType) * (size_t) numSamples);
+            std::memmove(queued, queued + numSamples, sizeof(SampleType) * (size_t) (fifoCount - numSamples));
+        }
+
+        fifoCount -= numSamples;
+    }
+
+private:
+    int factor = 1;
+    int numStages = 0;
+
+    HalfBandDecimator<SampleType> decimators[2][maxChannels];
+    HalfBandInterpolator<SampleType> interpolators[2][maxChannels];
+
+    // Output of each decimation stage, reused for the interpolator input of
+    // the stage above on the way back up
+    juce::AudioBuffer<SampleType> stageBuffers[2];
+
+    juce::AudioBuffer<SampleType> fifo;
+    int fifoCount = 0;
+
+    JUCE_LEAK_DETECTOR(TankResampler)
+};
@@ -34,6 +34,43 @@ ElouReverbAudioProcessorEditor::ElouReverbAudioProcessorEditor (ElouReverbAudioP
     setupSlider(panSlider, -1.0f, 1.0f, 0.01f);
     setupLabel(panLabel, "Pan");
     
+    setupSlider(predelaySlider, 0.0f, 500.0f, 1.0f, " ms");
+    setupLabel(predelayLabel, "Predelay");
+    
+    setupSlider(lowCutSlider, 20.0f, 2000.0f, 1.0f, " Hz");
+    setupLabel(lowCutLabel, "Low Cut");
+    
+    setupSlider(highCutSlider, 1000.0f, 20000.0f, 1.0f, " Hz");
+    setupLabel(highCutLabel, "High Cut");
+    
+    // Algorithm selector (items must exist before the attachment is created)
+    algorithmBox.addItemList({ "Freeverb", "FDN", "Convolution" }, 1);
+    addAndMakeVisible(algorithmBox);
+    
+    // Economy quality: one tank, synthesised width
+    qualityBox.addItemList({ "High", "Economy" }, 1);
+    addAndMakeVisible(qualityBox);
+    
+    // Oversampling for the Warmth stage
+    warmthModeBox.addItemList({ "Standard", "2x", "4x", "ADAA" }, 1);
+    addAndMakeVisible(warmthModeBox);
+    
+    // Impulse response loader for the convolution algorithm
+    auto impulseName = audioProcessor.getImpulseResponseName();
+    loadImpulseButton.setButtonText(impulseName.isEmpty() ? "Load IR..." : impulseName);
+    loadImpulseButton.onClick = [this]() {
+        impulseChooser = std::make_unique<juce::FileChooser>("Choose an impulse response",
+                                                             juce::File(),
+                                                             "*.wav;*.aif;*.aiff;*.flac");
+        impulseChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                    [this](const juce::FileChooser& chooser) {
+            auto file = chooser.getResult();
+            if (file.existsAsFile() && audioProcessor.loadImpulseResponse(file))
+                loadImpulseButton.setButtonText(audioProcessor.getImpulseResponseName());
+        });
+    };
+    addAndMakeVisible(loadImpulseButton);
+    
     // Custom text display for very long decay times
     roomSizeSlider.onValueChange = [this]() {
         float value = roomSizeSlider.getValue();
@@ -69,6 +106,13 @@ ElouReverbAudioProcessorEditor::ElouReverbAudioProcessorEditor (ElouReverbAudioP
         addAndMakeVisible(*button);
         colorButtons.push_back(std::move(button));
     }
+    
+    // CPU load as a share of the realtime budget
+    cpuLabel.setFont(juce::Font(12.0f));
+    cpuLabel.setJustificationType(juce::Justification::centredRight);
+    cpuLabel.setColour(juce::Label::textColourId, juce::Colours::white.withAlpha(0.6f));
+    addAndMakeVisible(cpuLabel);
+    startTimerHz(4);
 
     // Create attachments
     roomSizeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
@@ -81,6 +125,18 @@ ElouReverbAudioProcessorEditor::ElouReverbAudioProcessorEditor (ElouReverbAudioP
         audioProcessor.apvts, "saturation", saturationSlider);
     panAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.apvts, "pan", panSlider);
+    predelayAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.apvts, "predelay", predelaySlider);
+    lowCutAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.apvts, "lowCut", lowCutSlider);
+    highCutAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.apvts, "highCut", highCutSlider);
+    algorithmAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.apvts, "algorithm", algorithmBox);
+    qualityAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.apvts, "quality", qualityBox);
+    warmthModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.apvts, "warmthMode", warmthModeBox);
     
     setResizable(true, true);
     setResizeLimits(600, 400, 1200, 800);
@@ -89,11 +145,15 @@ ElouReverbAudioProcessorEditor::ElouReverbAudioProcessorEditor (ElouReverbAudioP
 
 ElouReverbAudioProcessorEditor::~ElouReverbAudioProcessorEditor()
 {
+    stopTimer();
     roomSizeSlider.setLookAndFeel(nullptr);
     dampingSlider.setLookAndFeel(nullptr);
     mixSlider.setLookAndFeel(nullptr);
     saturationSlider.setLookAndFeel(nullptr);
     panSlider.setLookAndFeel(nullptr);
+    predelaySlider.setLookAndFeel(nullptr);
+    lowCutSlider.setLookAndFeel(nullptr);
+    highCutSlider.setLookAndFeel(nullptr);
 }
 
 // Add these implementations after the constructor but before other functions
@@ -120,6 +180,19 @@ void ElouReverbAudioProcessorEditor::setupSlider(juce::Slider& slider, float min
     addAndMakeVisible(slider);
 }
 
+void ElouReverbAudioProcessorEditor::timerCallback()
+{
+    const auto stats = audioProcessor.getTimingStats();
+    if (stats.numBlocks == 0)
+        return;
+    
+    cpuLabel.setText(juce::String::formatted("CPU %.1f%%  p99 %.1f%%  max %.1f%%",
+                                             100.0 * stats.meanRealtimeRatio,
+                                             100.0 * stats.p99RealtimeRatio,
+                                             100.0 * stats.maxRealtimeRatio),
+                     juce::dontSendNotification);
+}
+
 void ElouReverbAudioProcessorEditor::setupLabel(juce::Label& label, const juce::String& text)
 {
     label.setText(text, juce::dontSendNotification);
@@ -212,6 +285,12 @@ void ElouReverbAudioProcessorEditor::resized()
 {
     auto bounds = getLocalBounds();
     
+    // Quality selector beside the version text, algorithm selector and IR
+    // loader under it
+    qualityBox.setBounds(getWidth() - 320, 24, 110, 22);
+    algorithmBox.setBounds(getWidth() - 320, 50, 150, 22);
+    loadImpulseButton.setBounds(getWidth() - 160, 50, 140, 22);
+    
     // Header space
     bounds.removeFromTop(80);
     
@@ -232,6 +311,8 @@ void ElouReverbAudioProcessorEditor::resized()
                                  20);
     }
     
+    cpuLabel.setBounds(colorSection.removeFromRight(240).reduced(10, 10));
+    
     // Calculate dimensions
     const int padding = 30;
     bounds.reduce(padding, padding);
@@ -264,16 +345,27 @@ void ElouReverbAudioProcessorEditor::resized()
     dampingSlider.setBounds(dampArea.withSizeKeepingCentre(knobSize, knobSize));
     mixSlider.setBounds(mixArea.withSizeKeepingCentre(knobSize, knobSize));
     
-    // Second row: Saturation and Pan
+    // Second row: Predelay, Low Cut, High Cut, Saturation and Pan
     auto bottomRow = mainSection;
+    const int columnWidth = bottomRow.getWidth() / 5;
+    auto predelayArea = bottomRow.removeFromLeft(columnWidth);
+    auto lowCutArea = bottomRow.removeFromLeft(columnWidth);
+    auto highCutArea = bottomRow.removeFromLeft(columnWidth);
     auto saturationArea = bottomRow.removeFromLeft(bottomRow.getWidth() / 2);
     auto panArea = bottomRow;
     
     // Second row labels
+    predelayLabel.setBounds(predelayArea.removeFromTop(labelHeight));
+    lowCutLabel.setBounds(lowCutArea.removeFromTop(labelHeight));
+    highCutLabel.setBounds(highCutArea.removeFromTop(labelHeight));
     saturationLabel.setBounds(saturationArea.removeFromTop(labelHeight));
+    warmthModeBox.setBounds(saturationArea.removeFromBottom(22).withSizeKeepingCentre(juce::jmin(100, saturationArea.getWidth()), 22));
     panLabel.setBounds(panArea.removeFromTop(labelHeight));
     
     // Second row knobs
+    predelaySlider.setBounds(predelayArea.withSizeKeepingCentre(knobSize, knobSize));
+    lowCutSlider.setBounds(lowCutArea.withSizeKeepingCentre(knobSize, knobSize));
+    highCutSlider.setBounds(highCutArea.withSizeKeepingCentre(knobSize, knobSize));
     saturationSlider.setBounds(saturationArea.withSizeKeepingCentre(knobSize, knobSize));
     panSlider.setBounds(panArea.withSizeKeepingCentre(knobSize, knobSize));
 }
@@ -132,7 +132,8 @@ private:
 /**
 */
 class ElouReverbAudioProcessorEditor : public juce::AudioProcessorEditor,
-                                     public juce::Button::Listener
+                                     public juce::Button::Listener,
+                                     private juce::Timer
 {
 public:
     ElouReverbAudioProcessorEditor (ElouReverbAudioProcessor&);
@@ -148,6 +149,7 @@ private:
     void setupSlider(juce::Slider& slider, float min, float max, float step, const char* suffix = "");
     void setupLabel(juce::Label& label, const juce::String& text);
     void createAttachments();
+    void timerCallback() override;
     
     // Easter egg properties
     int titleClickCount = 0;
@@ -164,21 +166,42 @@ private:
     juce::Slider mixSlider;  
     juce::Slider saturationSlider;
     juce::Slider panSlider;
+    juce::Slider predelaySlider;
+    juce::Slider lowCutSlider;
+    juce::Slider highCutSlider;
     
     juce::Label roomSizeLabel;
     juce::Label dampingLabel;
     juce::Label mixLabel;    
     juce::Label saturationLabel;
     juce::Label panLabel;
+    juce::Label predelayLabel;
+    juce::Label lowCutLabel;
+    juce::Label highCutLabel;
+    
+    juce::ComboBox algorithmBox;
+    juce::ComboBox qualityBox;
+    juce::ComboBox warmthModeBox;
+    juce::TextButton loadImpulseButton;
+    std::unique_ptr<juce::FileChooser> impulseChooser;
     
     std::vector<std::unique_ptr<ColorButton>> colorButtons;
     juce::Label colorLabel;
     
+    // processBlock CPU load, refreshed by the timer
+    juce::Label cpuLabel;
+    
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> roomSizeAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> dampingAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> mixAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> saturationAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> panAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> predelayAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> lowCutAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> highCutAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> algorithmAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> qualityAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> warmthModeAttachment;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ElouReverbAudioProcessorEditor)
 };
@@ -23,20 +23,37 @@ ElouReverbAudioProcessor::ElouReverbAudioProcessor()
     mixParameter = apvts.getRawParameterValue("mix");
     saturationParameter = apvts.getRawParameterValue("saturation"); // New
     panParameter = apvts.getRawParameterValue("pan");               // New
-
-    // Initialize reverb parameters
-    reverbParams.roomSize = roomSizeParameter->load();
-    reverbParams.damping = dampingParameter->load();
+    algorithmParameter = apvts.getRawParameterValue("algorithm");
+    warmthModeParameter = apvts.getRawParameterValue("warmthMode");
+    qualityParameter = apvts.getRawParameterValue("quality");
+    predelayParameter = apvts.getRawParameterValue("predelay");
+    lowCutParameter = apvts.getRawParameterValue("lowCut");
+    highCutParameter = apvts.getRawParameterValue("highCut");
+
+    // Hosts may ask for the tail length before the first block
+    updateParameters();
+    appliedParameterVersion = parameterVersion.load();
     
-    float mix = mixParameter->load();
-    reverbParams.wetLevel = mix;
-    reverbParams.dryLevel = 1.0f - mix;
+    for (auto* parameter : getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+            apvts.addParameterListener(withID->paramID, this);
     
-    reverb.setParameters(reverbParams);
+    logWriter->addRing(&audioLog);
+    startTimerHz(10);
 }
 
 ElouReverbAudioProcessor::~ElouReverbAudioProcessor()
 {
+    stopTimer();
+    impulseLoader.removeAllJobs(true, 10000);
+    logWriter->removeRing(&audioLog);
+    
+    for (auto* parameter : getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+            apvts.removeParameterListener(withID->paramID, this);
+    
+    delete pendingConvolver.exchange(nullptr);
+    delete retiredConvolver.exchange(nullptr);
 }
 
 //==============================================================================
@@ -74,7 +91,7 @@ bool ElouReverbAudioProcessor::isMidiEffect() const
 
 double ElouReverbAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailLengthSeconds.load();
 }
 
 int ElouReverbAudioProcessor::getNumPrograms()
@@ -104,8 +121,66 @@ void ElouReverbAudioProcessor::changeProgramName (int index, const juce::String&
 //==============================================================================
 void ElouReverbAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    reverb.reset();
-    reverb.setSampleRate(sampleRate);
+    this->sampleRate = sampleRate;
+    juce::ignoreUnused(samplesPerBlock);
+    
+    // The chain is compiled for the negotiated channel layout
+    const auto outputSet = getChannelLayoutOfBus(false, 0);
+    const bool monoInput = getChannelLayoutOfBus(true, 0).size() == 1;
+    ChannelConfiguration configuration;
+    configuration.numChannels = outputSet.size();
+    configuration.layout = outputSet.size() == 1 ? ChannelLayout::mono
+                         : outputSet.size() == 2 ? (monoInput ? ChannelLayout::monoToStereo : ChannelLayout::stereo)
+                         : ChannelLayout::surround;
+    if (configuration.layout == ChannelLayout::surround)
+        configuration.lfeChannel = outputSet.getChannelIndexForType(juce::AudioChannelSet::LFE);
+    surroundLayout = configuration.layout == ChannelLayout::surround;
+    
+    // The chain starts from the current parameter values
+    appliedParameterVersion = parameterVersion.load();
+    updateParameters();
+    
+    // Only the chain for the host's precision is allocated and run. It only
+    // ever sees sub-blocks, whatever the host's block size.
+    const int numFifoChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+    int latency = subBlockSize;
+    
+    if (isUsingDoublePrecision()) {
+        doubleFifo.prepare(numFifoChannels, subBlockSize);
+        doubleChain.prepare(sampleRate, subBlockSize, configuration, settings);
+        latency += doubleChain.getLatencySamples();
+    } else {
+        floatFifo.prepare(numFifoChannels, subBlockSize);
+        floatChain.prepare(sampleRate, subBlockSize, configuration, settings);
+        latency += floatChain.getLatencySamples();
+    }
+    
+    // The host reads the latency right after prepareToPlay(), so it is set
+    // here rather than left to the timer, which only picks up the Warmth
+    // mode switching oversampling on or off during playback
+    latencyInSamples.store(latency);
+    latencyChangePending.store(false);
+    setLatencySamples(latency);
+    
+    blockTiming.prepare(sampleRate);
+    
+    sleeping = false;
+    silentInputSamples = 0;
+    silentOutputSamples = 0;
+    mutedWetSamples = 0;
+    
+    // The IR has to be resampled to the new rate. Until that is done, a
+    // convolver that finished building before playback started can still be
+    // installed directly.
+    preparedSampleRate.store(sampleRate);
+    postImpulseJob();
+    
+    if (auto* next = pendingConvolver.exchange(nullptr))
+        convolver.reset(next);
+    delete retiredConvolver.exchange(nullptr);
+    
+    if (convolver != nullptr)
+        convolver->setParameters(convolverParams);
 }
 
 void ElouReverbAudioProcessor::releaseResources()
@@ -121,17 +196,24 @@ bool ElouReverbAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Mono, stereo, and the surround / immersive layouts the FDN can give a
+    // decorrelated late field per channel. Some plugin hosts, such as
+    // certain GarageBand versions, will only load plugins that support
+    // stereo bus layouts.
+    const auto output = layouts.getMainOutputChannelSet();
+    if (output != juce::AudioChannelSet::mono()
+     && output != juce::AudioChannelSet::stereo()
+     && output != juce::AudioChannelSet::create5point1()
+     && output != juce::AudioChannelSet::create7point1()
+     && output != juce::AudioChannelSet::create7point1point4())
         return false;
 
-    // This checks if the input layout matches the output layout
+    // The input layout must match the output layout, except for a mono
+    // input into a stereo output
    #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+    const auto input = layouts.getMainInputChannelSet();
+    if (input != output
+     && ! (input == juce::AudioChannelSet::mono() && output == juce::AudioChannelSet::stereo()))
         return false;
    #endif
 
@@ -140,7 +222,30 @@ bool ElouReverbAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
 }
 #endif
 
-void ElouReverbAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void ElouReverbAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    const ScopedAllocationTrap noAllocations;
+    const BlockTimingStats::ScopedBlock timing(blockTiming, buffer.getNumSamples());
+    process(buffer, floatChain, floatFifo);
+}
+
+// Hosts that mix in 64-bit get the chain in double precision, with no
+// conversion to float and back on either side
+void ElouReverbAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    const ScopedAllocationTrap noAllocations;
+    const BlockTimingStats::ScopedBlock timing(blockTiming, buffer.getNumSamples());
+    process(buffer, doubleChain, doubleFifo);
+}
+
+bool ElouReverbAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void ElouReverbAudioProcessor::process(juce::AudioBuffer<SampleType>& buffer, ReverbChain<SampleType>& chain,
+                                       SubBlockFifo<SampleType>& fifo)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -150,6 +255,93 @@ void ElouReverbAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
+    fifo.process(buffer, [this, &chain](juce::AudioBuffer<SampleType>& block) {
+        processSubBlock(block, chain);
+    });
+}
+
+// Everything below runs once per subBlockSize samples
+template <typename SampleType>
+void ElouReverbAudioProcessor::processSubBlock(juce::AudioBuffer<SampleType>& buffer, ReverbChain<SampleType>& chain)
+{
+    // Pick up a freshly loaded impulse response
+    if (retiredConvolver.load() == nullptr) {
+        if (auto* next = pendingConvolver.exchange(nullptr)) {
+            retiredConvolver.store(convolver.release());
+            convolver.reset(next);
+            convolver->setParameters(convolverParams);
+        }
+    }
+    
+    // Only recompute derived settings when a parameter has actually moved
+    const int version = parameterVersion.load();
+    if (version != appliedParameterVersion) {
+        appliedParameterVersion = version;
+        updateParameters();
+        
+        chain.setSettings(settings, convolver.get());
+        if (convolver != nullptr)
+            convolver->setParameters(convolverParams);
+        
+        const int latency = subBlockSize + chain.getLatencySamples();
+        if (latency != latencyInSamples.exchange(latency))
+            latencyChangePending.store(true);
+    }
+    
+    const int numSamples = buffer.getNumSamples();
+    
+    // While asleep, silent input means silent output. The tanks were cleared
+    // when we went to sleep, so waking up on the first block with input is
+    // the same as having processed the silence in between.
+    const auto silenceFloor = static_cast<SampleType>(silenceThreshold.load());
+    const bool inputSilent = buffer.getMagnitude(0, numSamples) < silenceFloor;
+    silentInputSamples = inputSilent ? juce::jmin(silentInputSamples + numSamples, chain.getMaxWetDelayInSamples(convolver.get())) : 0;
+    
+    if (sleeping) {
+        if (inputSilent) {
+            buffer.clear();
+            return;
+        }
+        sleeping = false;
+    }
+    
+    // At mix = 0 the wet gain is 0, so the tank is only heard while that gain
+    // fades out. After that the whole wet path is cleared and skipped, and it
+    // restarts from silence as the gain fades back in.
+    if (settings.mix <= 0.0f) {
+        mutedWetSamples = juce::jmin(mutedWetSamples + numSamples, chain.getWetFadeInSamples());
+        chain.setWetPathIdle(mutedWetSamples >= chain.getWetFadeInSamples(), convolver.get());
+    } else {
+        mutedWetSamples = 0;
+        chain.setWetPathIdle(false, convolver.get());
+    }
+    
+    chain.process(buffer, convolver.get());
+    
+    // Sleep once the input has been silent for longer than anything takes to
+    // get through the predelay and the tank, and the output for longer than
+    // anything takes to get out of the tank. A sparse early tail can fall
+    // silent for a whole block while its echoes are still in the delay lines.
+    const bool outputSilent = buffer.getMagnitude(0, numSamples) < silenceFloor;
+    silentOutputSamples = outputSilent ? juce::jmin(silentOutputSamples + numSamples, chain.getMaxWetDelayInSamples(convolver.get())) : 0;
+    
+    if (inputSilent && silentInputSamples >= chain.getWetDelayInSamples(convolver.get())
+        && silentOutputSamples >= chain.getTankDelayInSamples(convolver.get())) {
+        chain.clear(convolver.get());
+        sleeping = true;
+    }
+}
+
+void ElouReverbAudioProcessor::parameterChanged(const juce::String&, float)
+{
+    parameterVersion.fetch_add(1);
+}
+
+// Maps the current parameter values onto the chain settings. Audio thread
+// only, and only after a change, so the mapping maths stays off the
+// per-block path.
+void ElouReverbAudioProcessor::updateParameters()
+{
     // Get the decay time in seconds
     float decayTime = roomSizeParameter->load();
     
@@ -168,86 +360,198 @@ void ElouReverbAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
         roomSize = 0.95f + (0.98f - 0.95f) * logValue;
     }
     
-    // Update reverb parameters
-    reverbParams.roomSize = roomSize;
-    reverbParams.damping = dampingParameter->load();
-    
-    float mix = mixParameter->load();   
-    reverbParams.wetLevel = mix;
-    reverbParams.dryLevel = 1.0f - mix;
-    
-    reverb.setParameters(reverbParams);
-    
-    // Get saturation and pan parameters
-    float saturation = saturationParameter->load();
-    float pan = panParameter->load();
-
-    // Process reverb
-    if (buffer.getNumChannels() == 2) {
-        reverb.processStereo(buffer.getWritePointer(0),
-                            buffer.getWritePointer(1),
-                            buffer.getNumSamples());
-                            
-        // Apply saturation if needed
-        if (saturation > 0.01f) {
-            for (int channel = 0; channel < 2; ++channel) {
-                float* channelData = buffer.getWritePointer(channel);
-                for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
-                    channelData[sample] = applySaturation(channelData[sample], saturation);
-                }
-            }
-        }
+    // Freeverb and the convolver are stereo, so surround buses use the FDN
+    settings.algorithm = surroundLayout ? static_cast<int>(ReverbSettings::fdnAlgorithm)
+                                        : static_cast<int>(algorithmParameter->load());
+    settings.warmthMode = static_cast<int>(warmthModeParameter->load());
+    settings.quality = static_cast<int>(qualityParameter->load());
+    settings.decayTime = decayTime;
+    settings.roomSize = roomSize;
+    settings.damping = dampingParameter->load();
+    settings.mix = mixParameter->load();
+    settings.saturation = saturationParameter->load();
+    settings.pan = panParameter->load();
+    settings.predelayMs = predelayParameter->load();
+    settings.lowCut = lowCutParameter->load();
+    settings.highCut = highCutParameter->load();
+    
+    convolverParams.wetLevel = settings.mix;
+    convolverParams.dryLevel = 0.0f;
+    
+    // The FDN decays in exactly the decay time (an RT60, -60 dB). Freeverb's
+    // RT60 follows from its comb feedback instead. Either way the tail reaches
+    // the silence floor after floorDb / -60 RT60s. An IR simply lasts as long
+    // as it is.
+    const double floorDecibels = juce::Decibels::gainToDecibels(silenceThreshold.load(), -200.0f);
+    const double rt60 = settings.algorithm == ReverbSettings::freeverbAlgorithm
+                      ? FreeverbEngine<float>::getDecayTimeFor(roomSize)
+                      : static_cast<double>(decayTime);
+    const double decaySeconds = settings.algorithm == ReverbSettings::convolutionAlgorithm
+                              ? impulseLengthSeconds.load()
+                              : rt60 * juce::jmax(1.0, floorDecibels / -60.0);
+    const double tail = settings.predelayMs * 0.001 + decaySeconds;
+    
+    tailLengthSeconds.store(tail);
+}
+
+void ElouReverbAudioProcessor::timerCallback()
+{
+    // The engine the audio thread swapped out, with its tail thread
+    delete retiredConvolver.exchange(nullptr);
+    
+    if (! latencyChangePending.exchange(false))
+        return;
+    
+    // setLatencySamples() sends the host ChangeDetails().withLatencyChanged(true),
+    // and only when the value differs. Nothing else needs announcing: hosts
+    // poll getTailLengthSeconds().
+    const int latency = latencyInSamples.load();
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
+}
+
+void ElouReverbAudioProcessor::setSilenceThreshold(float decibels)
+{
+    silenceThreshold.store(juce::Decibels::decibelsToGain(decibels, -200.0f));
+    parameterVersion.fetch_add(1); // The tail length depends on it
+}
+
+bool ElouReverbAudioProcessor::loadImpulseResponse(const juce::File& file)
+{
+    if (! file.existsAsFile())
+        return false;
+    
+    apvts.state.setProperty("irPath", file.getFullPathName(), nullptr);
+    requestImpulseResponse(file);
+    return true;
+}
+
+juce::String ElouReverbAudioProcessor::getImpulseResponseName() const
+{
+    juce::String path = apvts.state.getProperty("irPath").toString();
+    return path.isEmpty() ? juce::String() : juce::File(path).getFileNameWithoutExtension();
+}
+
+bool ElouReverbAudioProcessor::isLoadingImpulseResponse() const noexcept
+{
+    return pendingImpulseJobs.load() > 0 || pendingConvolver.load() != nullptr;
+}
+
+void ElouReverbAudioProcessor::requestImpulseResponse(const juce::File& file)
+{
+    {
+        const juce::ScopedLock sl(impulseLock);
+        requestedImpulseFile = file;
+    }
+    
+    postImpulseJob();
+}
+
+void ElouReverbAudioProcessor::postImpulseJob()
+{
+    const int request = impulseRequest.fetch_add(1) + 1;
+    pendingImpulseJobs.fetch_add(1);
+    
+    impulseLoader.addJob([this, request] {
+        runImpulseJob(request);
+        pendingImpulseJobs.fetch_sub(1);
+    });
+}
+
+// IR loader thread: decodes the requested file if it changed, then builds a
+// convolver for it at the prepared sample rate
+void ElouReverbAudioProcessor::runImpulseJob(int request)
+{
+    if (request != impulseRequest.load())
+        return; // A newer job will do it
+    
+    juce::File file;
+    {
+        const juce::ScopedLock sl(impulseLock);
+        file = requestedImpulseFile;
+    }
+    
+    if (! (file == loadedImpulseFile)) {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
         
-        // Apply panning (simple linear law)
-        if (std::abs(pan) > 0.01f) {
-            float leftGain = (pan <= 0.0f) ? 1.0f : (1.0f - pan);
-            float rightGain = (pan >= 0.0f) ? 1.0f : (1.0f + pan);
-            
-            float* leftChannel = buffer.getWritePointer(0);
-            float* rightChannel = buffer.getWritePointer(1);
-            
-            for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
-                leftChannel[sample] *= leftGain;
-                rightChannel[sample] *= rightGain;
-            }
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        
+        // Cap the IR at the longest decay time the plugin offers
+        const int length = reader == nullptr ? 0
+                         : static_cast<int>(juce::jmin<juce::int64>(reader->lengthInSamples,
+                                                                    static_cast<juce::int64>(25.0 * reader->sampleRate)));
+        if (length <= 0) {
+            logMessage("Could not read the impulse response " + file.getFullPathName());
+            return;
         }
+        
+        impulseResponse.setSize(juce::jmin(2, static_cast<int>(reader->numChannels)), length);
+        reader->read(&impulseResponse, 0, length, 0, true, true);
+        impulseSampleRate = reader->sampleRate;
+        loadedImpulseFile = file;
     }
-    else {
-        reverb.processMono(buffer.getWritePointer(0), buffer.getNumSamples());
+    
+    rebuildConvolver(request);
+}
+
+// Builds a convolver for the loaded IR at the prepared sample rate, then
+// queues it for the audio thread (IR loader thread)
+void ElouReverbAudioProcessor::rebuildConvolver(int request)
+{
+    if (impulseResponse.getNumSamples() == 0)
+        return;
+    
+    const double rate = preparedSampleRate.load();
+    
+    // Resample the IR to the processing rate if needed
+    juce::AudioBuffer<float> resampled;
+    const juce::AudioBuffer<float>* source = &impulseResponse;
+    
+    if (impulseSampleRate != rate) {
+        const double ratio = impulseSampleRate / rate;
+        const int length = juce::jmax(1, static_cast<int>(impulseResponse.getNumSamples() / ratio));
+        resampled.setSize(impulseResponse.getNumChannels(), length);
         
-        // Apply saturation to mono signal if needed
-        if (saturation > 0.01f) {
-            float* channelData = buffer.getWritePointer(0);
-            for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
-                channelData[sample] = applySaturation(channelData[sample], saturation);
-            }
+        for (int channel = 0; channel < impulseResponse.getNumChannels(); ++channel) {
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process(ratio, impulseResponse.getReadPointer(channel),
+                                 resampled.getWritePointer(channel), length);
         }
-        
-        // Panning doesn't apply to mono signals
+        source = &resampled;
     }
+    
+    auto engine = std::make_unique<ConvolutionReverb>();
+    engine->prepare(*source, rate, subBlockSize);
+    
+    if (request != impulseRequest.load())
+        return; // Overtaken while building
+    
+    delete retiredConvolver.exchange(nullptr);
+    delete pendingConvolver.exchange(engine.release());
+    
+    impulseLengthSeconds.store(source->getNumSamples() / rate);
+    parameterVersion.fetch_add(1); // The tail length depends on it
 }
 
-// Add this saturation helper function
-float ElouReverbAudioProcessor::applySaturation(float sample, float amount)
+void ElouReverbAudioProcessor::logFromAudioThread(const char* message) noexcept
 {
-    // Simple tanh-based soft clipping with drive control
-    float drive = 1.0f + 15.0f * amount;
-    return std::tanh(sample * drive) / (1.0f + amount * 3.0f);
+    audioLog.push(message);
 }
 
-// Add this implementation to your PluginProcessor.cpp file:
 void ElouReverbAudioProcessor::logMessage(const juce::String& message)
 {
-    // Get the desktop folder path
-    juce::File logFile(juce::File::getSpecialLocation(juce::File::userDesktopDirectory)
-                       .getChildFile("ElouReverb_log.txt"));
-    
-    // Create a timestamp
-    juce::Time now = juce::Time::getCurrentTime();
-    juce::String timestamp = now.formatted("%H:%M:%S.%ms ");
-    
-    // Append the message to the log file
-    logFile.appendText(timestamp + message + "\n");
+    logWriter->write(message);
+}
+
+void ElouReverbAudioProcessor::setLogFile(const juce::File& file)
+{
+    logWriter->setLogFile(file);
+}
+
+juce::File ElouReverbAudioProcessor::getLogFile() const
+{
+    return logWriter->getLogFile();
 }
 
 //==============================================================================
@@ -275,6 +579,11 @@ void ElouReverbAudioProcessor::setStateInformation (const void* data, int sizeIn
     if (xmlState.get() != nullptr)
         if (xmlState->hasTagName(apvts.state.getType()))
             apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
+    
+    // Reload the impulse response the session was using, in the background
+    juce::String impulsePath = apvts.state.getProperty("irPath").toString();
+    if (impulsePath.isNotEmpty())
+        requestImpulseResponse(juce::File(impulsePath));
 }
 
 //==============================================================================
@@ -324,6 +633,14 @@ juce::AudioProcessorValueTreeState::ParameterLayout ElouReverbAudioProcessor::cr
         0.2f                                   // default value
     ));
         
+    // Warmth oversampling
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("warmthMode", 1),    // parameter ID with version hint
+        "Warmth Mode",                         // parameter name
+        juce::StringArray { "Standard", "2x", "4x", "ADAA" },
+        0                                      // default index
+    ));
+        
     // Pan parameter
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID("pan", 1),           // parameter ID with version hint
@@ -333,5 +650,46 @@ juce::AudioProcessorValueTreeState::ParameterLayout ElouReverbAudioProcessor::cr
         0.0f                                   // default value
     ));
     
+    // Predelay parameter (wet path only)
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID("predelay", 1),      // parameter ID with version hint
+        "Predelay",                            // parameter name
+        0.0f,                                  // minimum value
+        ReverbChain<float>::maxPredelayMs,     // maximum value
+        0.0f                                   // default value
+    ));
+    
+    // Low cut on the wet signal (off at the minimum)
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID("lowCut", 1),        // parameter ID with version hint
+        "Low Cut",                             // parameter name
+        juce::NormalisableRange<float>(WetFilter<float>::minimumLowCut, 2000.0f, 1.0f, 0.3f),
+        WetFilter<float>::minimumLowCut        // default value
+    ));
+    
+    // High cut on the wet signal (off at the maximum)
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID("highCut", 1),       // parameter ID with version hint
+        "High Cut",                            // parameter name
+        juce::NormalisableRange<float>(1000.0f, WetFilter<float>::maximumHighCut, 1.0f, 0.3f),
+        WetFilter<float>::maximumHighCut       // default value
+    ));
+    
+    // Algorithm parameter
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("algorithm", 1),     // parameter ID with version hint
+        "Algorithm",                           // parameter name
+        juce::StringArray { "Freeverb", "FDN", "Convolution" },
+        0                                      // default index
+    ));
+    
+    // Economy runs a single mono tank and synthesises the width
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("quality", 1),       // parameter ID with version hint
+        "Quality",                             // parameter name
+        juce::StringArray { "High", "Economy" },
+        0                                      // default index
+    ));
+    
     return layout;
 }
@@ -9,11 +9,18 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "ReverbChain.h"
+#include "SubBlockFifo.h"
+#include "AllocationTrap.h"
+#include "RealtimeLog.h"
+#include "TimingStats.h"
 
 //==============================================================================
 /**
 */
-class ElouReverbAudioProcessor  : public juce::AudioProcessor
+class ElouReverbAudioProcessor  : public juce::AudioProcessor,
+                                  private juce::AudioProcessorValueTreeState::Listener,
+                                  private juce::Timer
 {
 public:
     //==============================================================================
@@ -29,6 +36,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -58,17 +67,145 @@ public:
     
     // Add this method to reset the reverb state
     void clearReverbState() {
-        reverb.reset();
+        floatChain.resetTanks();
+        doubleChain.resetTanks();
     }
     
-    static void logMessage(const juce::String& message);
+    // Loads an impulse response for the convolution algorithm (message
+    // thread). Only posts the request: the file is decoded, resampled and
+    // partitioned on the IR loader thread, and the audio thread picks up the
+    // result. Returns false if the file doesn't exist; a file that can't be
+    // decoded is logged and leaves the current IR in place.
+    bool loadImpulseResponse(const juce::File& file);
+    juce::String getImpulseResponseName() const;
+    
+    // True until the last requested IR is built and in use by the audio thread
+    bool isLoadingImpulseResponse() const noexcept;
+    
+    // Level below which input counts as silent and the tail as finished.
+    // Once both are true the reverb sleeps until input returns.
+    void setSilenceThreshold(float decibels);
+    
+    // Whether the last block found the reverb asleep (audio thread)
+    bool isSleeping() const noexcept { return sleeping; }
+    
+    // Timestamped log lines, written to disk by a background thread.
+    // logFromAudioThread() is for the audio thread only: it copies the
+    // message into this instance's lock-free ring and returns. logMessage()
+    // is for any other thread; it goes through this instance's writer, so
+    // the writer thread isn't started and stopped for every message.
+    void logFromAudioThread(const char* message) noexcept;
+    void logMessage(const juce::String& message);
+    
+    // Where the log goes (shared by every instance in the process)
+    void setLogFile(const juce::File& file);
+    juce::File getLogFile() const;
+    
+    // CPU time of processBlock over the last second or so of audio. Lock-free
+    // and safe to poll from any thread.
+    BlockTimingStats::TimingSnapshot getTimingStats() const noexcept { return blockTiming.getSnapshot(); }
+    
+    // The same per StageProfiler::Stage. Empty unless the plugin was built
+    // with ELOUREVERB_PROFILE_STAGES.
+    BlockTimingStats::TimingSnapshot getStageTimingStats(int stage) const noexcept
+    {
+        return isUsingDoublePrecision() ? doubleChain.getStageTimingStats(stage) : floatChain.getStageTimingStats(stage);
+    }
     
 private:
     // This should be the ONLY declaration of this function:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     
-    juce::Reverb reverb;
-    juce::Reverb::Parameters reverbParams;
+    // The whole DSP chain, once per precision. Only the one matching the
+    // host's processing precision is prepared and run.
+    ReverbChain<float> floatChain;
+    ReverbChain<double> doubleChain;
+    
+    // Host buffers of any size are re-blocked into subBlockSize samples, so
+    // parameter updates, sleep checks and the chain all run on a fixed grid
+    // and a 1-sample call costs no more per sample than an 8192-sample one.
+    // This adds subBlockSize samples of latency (0.7 ms at 44.1 kHz). 32 is
+    // also the convolver's head partition, which has no latency of its own
+    // but redoes a whole partition FFT on every shorter call; fed from the
+    // FIFO it does one per partition.
+    static constexpr int subBlockSize = 32;
+    SubBlockFifo<float> floatFifo;
+    SubBlockFifo<double> doubleFifo;
+    
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer, ReverbChain<SampleType>& chain, SubBlockFifo<SampleType>& fifo);
+    template <typename SampleType>
+    void processSubBlock(juce::AudioBuffer<SampleType>& block, ReverbChain<SampleType>& chain);
+    
+    // Convolution engine: built off the audio thread and handed over without
+    // locks. The audio thread adopts a pending engine only once the previous
+    // retired one has been collected, so it never has to delete anything.
+    // The timer frees a retired engine within a tick, and the IR loader
+    // frees it before it queues another.
+    std::unique_ptr<ConvolutionReverb> convolver;
+    std::atomic<ConvolutionReverb*> pendingConvolver { nullptr };
+    std::atomic<ConvolutionReverb*> retiredConvolver { nullptr };
+    ConvolutionReverb::Parameters convolverParams;
+    
+    // IR loading and convolver builds run as jobs on impulseLoader. Each
+    // job brings the convolver up to date with the latest requested file
+    // and the prepared sample rate, so a job that a newer one has overtaken
+    // has nothing left to do and returns.
+    void requestImpulseResponse(const juce::File& file);
+    void postImpulseJob();
+    void runImpulseJob(int request);
+    juce::ThreadPool impulseLoader { juce::ThreadPoolOptions{}.withThreadName("ElouReverb IR loader").withNumberOfThreads(1) };
+    std::atomic<int> impulseRequest { 0 };
+    std::atomic<int> pendingImpulseJobs { 0 };
+    std::atomic<double> preparedSampleRate { 44100.0 };
+    
+    // File the IR should come from (guarded by impulseLock)
+    juce::CriticalSection impulseLock;
+    juce::File requestedImpulseFile;
+    
+    // Impulse response as loaded from disk (IR loader thread only)
+    juce::File loadedImpulseFile;
+    juce::AudioBuffer<float> impulseResponse;
+    double impulseSampleRate = 0.0;
+    
+    // Any parameter change bumps parameterVersion (from whichever thread made
+    // it). processBlock only recomputes the derived DSP settings when the
+    // version differs from the one it last applied.
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void updateParameters();
+    std::atomic<int> parameterVersion { 0 };
+    int appliedParameterVersion = -1;
+    
+    // Parameter values as of the last updateParameters()
+    ReverbSettings settings;
+    
+    // Tail length reported to the host: computed on the audio thread when a
+    // parameter changes, and read by the host whenever it asks
+    std::atomic<double> tailLengthSeconds { 0.0 };
+    std::atomic<double> impulseLengthSeconds { 0.0 };
+    
+    // Latency of the sub-blocking and the Warmth oversampling. prepareToPlay()
+    // sets it directly. A Warmth mode change during playback changes it on
+    // the audio thread, which only raises latencyChangePending; posting a
+    // message from it could allocate or block, so a timer polls the flag.
+    // The same timer frees the retired convolver.
+    void timerCallback() override;
+    std::atomic<bool> latencyChangePending { false };
+    std::atomic<int> latencyInSamples { 0 };
+    
+    // Logging (see logFromAudioThread). audioLog has the audio thread as its
+    // only producer.
+    juce::SharedResourcePointer<LogWriter> logWriter;
+    LogRing audioLog;
+    
+    // Filled by processBlock (see getTimingStats)
+    BlockTimingStats blockTiming;
+    
+    // Sleep mode (see setSilenceThreshold)
+    std::atomic<float> silenceThreshold { juce::Decibels::decibelsToGain(-120.0f, -200.0f) };
+    bool sleeping = false;
+    int silentInputSamples = 0;
+    int silentOutputSamples = 0;
     
     // Parameter pointers
     std::atomic<float>* roomSizeParameter = nullptr;
@@ -76,24 +213,21 @@ private:
     std::atomic<float>* mixParameter = nullptr;  // Single mix parameter
     std::atomic<float>* saturationParameter = nullptr; // New saturation parameter
     std::atomic<float>* panParameter = nullptr;        // New pan parameter
+    std::atomic<float>* algorithmParameter = nullptr;  // See ReverbSettings::Algorithm
+    std::atomic<float>* warmthModeParameter = nullptr; // See ReverbSettings::WarmthMode
+    std::atomic<float>* qualityParameter = nullptr;    // See ReverbSettings::Quality
     std::atomic<float>* predelayParameter = nullptr;    // New
     std::atomic<float>* lowCutParameter = nullptr;      // New
     std::atomic<float>* highCutParameter = nullptr;     // New
     
-    // Filters
-    juce::IIRFilter lowCutFilter[2];  // Stereo low cut filter (high pass)
-    juce::IIRFilter highCutFilter[2]; // Stereo high cut filter (low pass)
-    
-    // Delay buffer for predelay
-    juce::AudioBuffer<float> predelayBuffer;
-    int predelayBufferWritePosition = 0;
-    int predelayBufferSize = 0;
-    int maxDelayInSamples = 0;
     double sampleRate = 44100.0;
+    bool surroundLayout = false; // Set in prepareToPlay; see updateParameters
+    
+    // At mix = 0 the wet gain fades out, then the whole wet path is skipped
+    int mutedWetSamples = 0;
     
     // Helper functions
-    float applySaturation(float sample, float amount);
-    void applyPredelay(juce::AudioBuffer<float>& buffer, float delayTimeMs);
+    void rebuildConvolver(int request);
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ElouReverbAudioProcessor)
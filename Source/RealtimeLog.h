@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    RealtimeLog.h
+
+    Logging that the audio thread can use: messages go into a lock-free ring
+    and a background thread writes them to disk.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Single-producer, single-consumer ring of fixed-size log records.
+
+    push() copies the message and a millisecond timestamp into a preallocated
+    slot. It doesn't lock or allocate, so it is safe on the audio thread. If
+    the ring is full, the message is dropped and counted. Messages longer
+    than maxMessageLength are truncated.
+*/
+class LogRing
+{
+public:
+    static constexpr int capacity = 256;
+    static constexpr int maxMessageLength = 119;
+
+    struct Record
+    {
+        juce::int64 timeMs = 0;
+        char text[maxMessageLength + 1] {};
+    };
+
+    LogRing() = default;
+
+    // Producer side
+    bool push(const char* message) noexcept
+    {
+        const auto scope = fifo.write(1);
+        if (scope.blockSize1 == 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        auto& record = records[(size_t) scope.startIndex1];
+        record.timeMs = juce::Time::currentTimeMillis();
+
+        int length = 0;
+        while (length < maxMessageLength && message[length] != 0) {
+            record.text[length] = message[length];
+            ++length;
+        }
+        record.text[length] = 0;
+        return true;
+    }
+
+    // Consumer side: write(const Record&) runs on every queued record, oldest
+    // first. Returns the number of messages dropped since the last drain.
+    template <typename Writer>
+    int drain(Writer&& write)
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+        scope.forEach([&](int index) { write(records[(size_t) index]); });
+        return dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<Record, capacity> records;
+    std::atomic<int> dropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(LogRing)
+};
+
+//==============================================================================
+/**
+    Background thread that drains every registered LogRing into a text file.
+    One instance is shared by all plugin instances in the process, through a
+    juce::SharedResourcePointer.
+
+    When the file grows past maxFileBytes it is renamed to name.1.ext, older
+    backups shift up, and a fresh file is started. At most numBackups are
+    kept. By default the file is ElouReverb_log.txt on the desktop;
+    setLogFile() changes it.
+
+    write() serves every thread other than the audio thread. Those callers
+    share one ring, and a lock serialises them as its single producer. It
+    may block, but it never waits for the disk.
+*/
+class LogWriter : private juce::Thread
+{
+public:
+    static constexpr juce::int64 maxFileBytes = 1024 * 1024;
+    static constexpr int numBackups = 3;
+
+    LogWriter() : juce::Thread("ElouReverb log")
+    {
+        logFile = juce::File::getSpecialLocation(juce::File::userDesktopDirectory).getChildFile("ElouReverb_log.txt");
+        addRing(&sharedRing);
+        startThread(juce::Thread::Priority::background);
+    }
+
+    ~LogWriter() override
+    {
+        stopThread(2000);
+        flush();
+    }
+
+    // Rings must be removed before they are destroyed. Whatever is still
+    // queued in one is written out first.
+    void addRing(LogRing* ring)
+    {
+        const juce::ScopedLock sl(writeLock);
+        rings.addIfNotAlreadyThere(ring);
+    }
+
+    void removeRing(LogRing* ring)
+    {
+        const juce::ScopedLock sl(writeLock);
+        drain(*ring);
+        rings.removeFirstMatchingValue(ring);
+
+        if (stream != nullptr)
+            stream->flush();
+    }
+
+    // Not for the audio thread: give it its own LogRing instead
+    void write(const juce::String& message)
+    {
+        const juce::SpinLock::ScopedLockType sl(producerLock);
+        sharedRing.push(message.toRawUTF8());
+    }
+
+    void setLogFile(const juce::File& file)
+    {
+        const juce::ScopedLock sl(writeLock);
+        if (file == logFile)
+            return;
+
+        stream.reset();
+        logFile = file;
+    }
+
+    juce::File getLogFile() const
+    {
+        const juce::ScopedLock sl(writeLock);
+        return logFile;
+    }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit()) {
+            wait(100);
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        const juce::ScopedLock sl(writeLock);
+
+        for (auto* ring : rings)
+            drain(*ring);
+
+        if (stream != nullptr)
+            stream->flush();
+    }
+
+    void drain(LogRing& ring)
+    {
+        const int dropped = ring.drain([this](const LogRing::Record& record) {
+            const juce::Time time(record.timeMs);
+            writeLine(juce::String::formatted("%02d:%02d:%02d.%03d ", time.getHours(), time.getMinutes(),
+                                              time.getSeconds(), time.getMilliseconds())
+                      + juce::String::fromUTF8(record.text));
+        });
+
+        if (dropped > 0)
+            writeLine("(" + juce::String(dropped) + " messages dropped)");
+    }
+
+    void writeLine(const juce::String& line)
+    {
+        if (stream != nullptr && stream->getPosition() >= maxFileBytes) {
+            stream.reset();
+            rotate();
+        }
+
+        if (stream == nullptr) {
+            logFile.getParentDirectory().createDirectory();
+            stream = logFile.createOutputStream();
+            if (stream == nullptr)
+                return;
+        }
+
+        *stream << line << "\n";
+    }
+
+    // name.txt -> name.1.txt -> name.2.txt ..., dropping the oldest
+    void rotate()
+    {
+        auto backup = [this](int index) {
+            return logFile.getSiblingFile(logFile.getFileNameWithoutExtension() + "." + juce::String(index)
+                                          + logFile.getFileExtension());
+        };
+
+        backup(numBackups).deleteFile();
+        for (int index = numBackups - 1; index >= 1; --index)
+            backup(index).moveFileTo(backup(index + 1));
+        logFile.moveFileTo(backup(1));
+    }
+
+    juce::CriticalSection writeLock;    // rings, logFile and stream
+    juce::Array<LogRing*> rings;
+    juce::File logFile;
+    std::unique_ptr<juce::FileOutputStream> stream;
+
+    juce::SpinLock producerLock;
+    LogRing sharedRing;
+
+    JUCE_DECLARE_NON_COPYABLE(LogWriter)
+};
@@ -0,0 +1,828 @@
+/*
+  ==============================================================================
+
+    ReverbChain.h
+
+    The processing chain behind the plugin, templated on the sample type so
+    it can run in single or double precision.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FreeverbEngine.h"
+#include "FdnEngine.h"
+#include "ConvolutionEngine.h"
+#include "WetFilter.h"
+#include "Saturation.h"
+#include "Multirate.h"
+#include "TimingStats.h"
+
+//==============================================================================
+/**
+    Parameter values after mapping, as the chain uses them. The processor
+    computes them once per parameter change and hands them to whichever chain
+    is running.
+*/
+struct ReverbSettings
+{
+    // Values of the "algorithm" parameter
+    enum Algorithm
+    {
+        freeverbAlgorithm = 0,
+        fdnAlgorithm,
+        convolutionAlgorithm
+    };
+
+    // Values of the "warmthMode" parameter
+    enum WarmthMode
+    {
+        standardWarmth = 0,
+        oversampled2xWarmth,
+        oversampled4xWarmth,
+        adaaWarmth
+    };
+
+    // Values of the "quality" parameter
+    enum Quality
+    {
+        highQuality = 0,
+        economyQuality
+    };
+
+    int algorithm = freeverbAlgorithm;
+    int warmthMode = standardWarmth;
+    int quality = highQuality;
+    float decayTime = 8.0f;   // RT60 in seconds (FDN)
+    float roomSize = 0.95f;   // decayTime mapped onto Freeverb's room size
+    float damping = 0.5f;
+    float mix = 0.33f;
+    float saturation = 0.0f;
+    float pan = 0.0f;
+    float predelayMs = 0.0f;
+    float lowCut = 20.0f;
+    float highCut = 20000.0f;
+};
+
+// Channel layouts the chain is compiled for
+enum class ChannelLayout
+{
+    mono,
+    stereo,
+    monoToStereo,   // One input channel driving a stereo wet field
+    surround        // 5.1, 7.1, 7.1.4: FDN late field with one tap per channel
+};
+
+// The bus the chain runs on
+struct ChannelConfiguration
+{
+    ChannelLayout layout = ChannelLayout::stereo;
+    int numChannels = 2;
+    int lfeChannel = -1;    // Gets the dry signal only, or -1 for none
+};
+
+//==============================================================================
+/**
+    Predelay, reverb tank, wet filter, dry mix, Warmth and pan.
+
+    process() runs the whole chain fusedChunkSize samples at a time, so the
+    tank output is still in L1 while it is filtered, mixed, shaped and panned.
+
+    SampleType is float or double. The processor owns one chain per precision
+    and prepares the one the host asked for. The convolution engine is shared
+    and always runs in float (the IR itself is at most 24-bit), so a double
+    chain converts each chunk through a float scratch buffer around it.
+
+    The chain is compiled once per channel layout. prepare() picks the
+    instantiation for the negotiated bus layout, so the per-chunk code has
+    no layout branches (and, for mono and stereo, a constant channel count).
+
+    Mono-in/stereo-out feeds the one input channel to both halves of the
+    tank and returns a full stereo wet field; the dry signal and the
+    predelay only handle that one channel.
+
+    Economy quality runs one tank on the summed input and synthesises the
+    stereo width from it: Freeverb's mid-only path, or an FDN with half the
+    lines. It roughly halves the tank's cost for background reverbs. Mono
+    Freeverb, convolution and surround buses are unaffected.
+
+    At high sample rates the Freeverb and FDN tanks run decimated, at a half
+    or a quarter of the host rate, but never below 44.1 kHz (see
+    tankDecimationFor()). The half-band filters around the tank delay the
+    wet signal a little; the predelay is shortened by the same amount to
+    make up for it.
+
+    Surround buses always run the FDN: each channel gets its own output tap
+    of the one network, so the late field is decorrelated across channels
+    and an extra channel costs only its taps. The LFE gets no wet signal.
+    The wet filter runs on channel pairs, one pair per register.
+*/
+template <typename SampleType>
+class ReverbChain
+{
+public:
+    static constexpr float maxPredelayMs = 500.0f;
+    static constexpr int maxChannels = 12; // 7.1.4
+
+    // Allocates, so call this from prepareToPlay
+    void prepare(double newSampleRate, int maximumBlockSize, const ChannelConfiguration& newConfiguration,
+                 const ReverbSettings& initialSettings)
+    {
+        jassert(newConfiguration.numChannels <= maxChannels);
+
+        sampleRate = newSampleRate;
+        maxBlockSize = maximumBlockSize;
+        configuration = newConfiguration;
+        configuration.numChannels = juce::jlimit(1, maxChannels, configuration.numChannels);
+        const int numChannels = configuration.numChannels;
+
+        switch (configuration.layout) {
+            case ChannelLayout::mono:         processFunction = &ReverbChain::processLayout<ChannelLayout::mono>; break;
+            case ChannelLayout::stereo:       processFunction = &ReverbChain::processLayout<ChannelLayout::stereo>; break;
+            case ChannelLayout::monoToStereo: processFunction = &ReverbChain::processLayout<ChannelLayout::monoToStereo>; break;
+            case ChannelLayout::surround:     processFunction = &ReverbChain::processLayout<ChannelLayout::surround>; break;
+        }
+
+        currentAlgorithm = initialSettings.algorithm;
+        currentQuality = initialSettings.quality;
+        currentWarmthMode = initialSettings.warmthMode;
+
+        // The tanks run at the reduced rate
+        const int decimation = tankDecimationFor(sampleRate);
+        tankResampler.prepare(decimation, numChannels, fusedChunkSize);
+        const double tankSampleRate = sampleRate / decimation;
+
+        reverb.reset();
+        reverb.setSampleRate(tankSampleRate);
+
+        fdn.setSampleRate(tankSampleRate);
+        fdn.reset();
+        economyFdn.setSampleRate(tankSampleRate);
+
+        for (auto& wetFilter : wetFilters)
+            wetFilter.setSampleRate(sampleRate);
+
+        profiler.prepare(sampleRate);
+
+        // Room for the longest predelay plus one block, so a block is always
+        // written before any of it is read back
+        maxDelayInSamples = (int) std::ceil(maxPredelayMs * 0.001 * sampleRate);
+        predelayBufferSize = maxDelayInSamples + maximumBlockSize;
+        predelayBuffer.setSize(numChannels, predelayBufferSize);
+        predelayBuffer.clear();
+        predelayBufferWritePosition = 0;
+        predelayFadeBuffer.setSize(numChannels, maximumBlockSize);
+        predelaySamples = toPredelaySamples(initialSettings.predelayMs);
+        previousPredelaySamples = predelaySamples;
+        predelayFadePosition = predelayFadeLength;
+
+        dryBuffer.setSize(numChannels, fusedChunkSize);
+
+        if constexpr (! std::is_same_v<SampleType, float>)
+            convolutionScratch.setSize(2, fusedChunkSize);
+
+        for (int i = 0; i < 2; ++i) {
+            warmthOversamplers[i] = std::make_unique<juce::dsp::Oversampling<SampleType>>(
+                (size_t) numChannels, (size_t) (i + 1), juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR, true, true);
+            warmthOversamplers[i]->initProcessing((size_t) maximumBlockSize);
+        }
+
+        for (auto& state : warmthAdaaState)
+            state = {};
+
+        // Start from the current settings rather than switching to them
+        setSettings(initialSettings, nullptr);
+
+        lastDryGain = dryGainFor(initialSettings.mix);
+        wetPathIdle = false;
+    }
+
+    // Pushes new settings into the stages. Audio thread, after a parameter change.
+    void setSettings(const ReverbSettings& newSettings, ConvolutionReverb* convolver)
+    {
+        settings = newSettings;
+
+        // Reset the tank we switch to so it doesn't replay a stale tail. A
+        // quality change switches tanks too (or, for Freeverb, the half of
+        // the tank that runs).
+        if (settings.algorithm != currentAlgorithm || settings.quality != currentQuality) {
+            if (settings.algorithm == ReverbSettings::fdnAlgorithm) {
+                fdn.reset();
+                economyFdn.reset();
+            } else if (settings.algorithm == ReverbSettings::convolutionAlgorithm) {
+                if (settings.algorithm != currentAlgorithm && convolver != nullptr)
+                    convolver->reset();
+            } else {
+                reverb.reset();
+            }
+
+            // The resampler's filters still hold the old tank's output
+            tankResampler.reset();
+            currentAlgorithm = settings.algorithm;
+            currentQuality = settings.quality;
+        }
+
+        if (settings.algorithm == ReverbSettings::fdnAlgorithm) {
+            // The FDN reaches the requested decay time directly
+            typename FdnEngine<SampleType, 16>::Parameters fdnParams;
+            fdnParams.decayTime = settings.decayTime;
+            fdnParams.damping = settings.damping;
+            fdnParams.wetLevel = settings.mix;
+            fdnParams.dryLevel = 0.0f;
+            fdn.setParameters(fdnParams);
+
+            typename FdnEngine<SampleType, 8>::Parameters economyParams;
+            economyParams.decayTime = fdnParams.decayTime;
+            economyParams.damping = fdnParams.damping;
+            economyParams.wetLevel = fdnParams.wetLevel;
+            economyParams.dryLevel = fdnParams.dryLevel;
+            economyFdn.setParameters(economyParams);
+        } else if (settings.algorithm == ReverbSettings::freeverbAlgorithm) {
+            auto reverbParams = reverb.getParameters();
+            reverbParams.roomSize = settings.roomSize;
+            reverbParams.damping = settings.damping;
+            reverbParams.wetLevel = settings.mix;
+            reverbParams.dryLevel = 0.0f;
+            reverb.setParameters(reverbParams);
+        }
+
+        for (auto& wetFilter : wetFilters)
+            wetFilter.setCutoffs(settings.lowCut, settings.highCut);
+
+        // A newly selected oversampler starts from clean filter state
+        if (settings.warmthMode != currentWarmthMode) {
+            currentWarmthMode = settings.warmthMode;
+            if (auto* oversampler = getWarmthOversampler())
+                oversampler->reset();
+            for (auto& state : warmthAdaaState)
+                state = {};
+        }
+    }
+
+    // Latency of the current Warmth mode
+    int getLatencySamples() const
+    {
+        if (auto* oversampler = getWarmthOversampler())
+            return juce::roundToInt(oversampler->getLatencyInSamples());
+        return 0;
+    }
+
+    // Longest a sample can stay inside the tank without any of it reaching
+    // the output. Once the output has been silent this long (and nothing new
+    // came in), the tank holds nothing above the floor. For the convolver it
+    // is the IR length, the longest any input keeps reaching the output.
+    // Never less than one sample, so sleeping always needs a silent output.
+    int getTankDelayInSamples(const ConvolutionReverb* convolver) const noexcept
+    {
+        if (currentAlgorithm == ReverbSettings::convolutionAlgorithm && configuration.layout != ChannelLayout::surround)
+            return juce::jmax(1, convolver != nullptr ? convolver->getImpulseLength() : 0);
+
+        // The tanks count in reduced-rate samples
+        return getLongestTankDelay() * tankResampler.getFactor() + tankResampler.getLatencySamples();
+    }
+
+    // The same through the predelay and the tank (the longer predelay read
+    // position while it crossfades)
+    int getWetDelayInSamples(const ConvolutionReverb* convolver) const noexcept
+    {
+        return juce::jmax(predelaySamples, previousPredelaySamples) + getTankDelayInSamples(convolver);
+    }
+
+    int getMaxWetDelayInSamples(const ConvolutionReverb* convolver) const noexcept
+    {
+        const int longestTankDelay = juce::jmax(reverb.getLongestDelayInSamples(), fdn.getLongestDelayInSamples(),
+                                                economyFdn.getLongestDelayInSamples());
+        const int longestAlgorithmicDelay = longestTankDelay * tankResampler.getFactor() + tankResampler.getLatencySamples();
+        return maxDelayInSamples + juce::jmax(longestAlgorithmicDelay, convolver != nullptr ? convolver->getImpulseLength() : 0);
+    }
+
+    // How long the wet signal takes to fade out once the mix reaches 0: the
+    // engines' 10 ms wet gain ramp (at the tank rate, so the same time) and
+    // the resampler's delay on the way out. After that the tank can't be heard.
+    int getWetFadeInSamples() const noexcept
+    {
+        return (int) std::ceil(0.01 * sampleRate) + tankResampler.getLatencySamples();
+    }
+
+    // Per-stage CPU time, when built with ELOUREVERB_PROFILE_STAGES. Any thread.
+    BlockTimingStats::TimingSnapshot getStageTimingStats(int stage) const noexcept
+    {
+        return profiler.getSnapshot(stage);
+    }
+
+    // At mix = 0, once the wet gain has faded out, the whole wet path is
+    // cleared and skipped until the mix comes back up
+    void setWetPathIdle(bool shouldBeIdle, ConvolutionReverb* convolver)
+    {
+        if (shouldBeIdle && ! wetPathIdle)
+            clearWetPath(convolver);
+        wetPathIdle = shouldBeIdle;
+    }
+
+    // Runs the chain in place over the channels of the prepared layout
+    void process(juce::AudioBuffer<SampleType>& buffer, ConvolutionReverb* convolver)
+    {
+        (this->*processFunction)(buffer, convolver);
+    }
+
+    // Clears every stage that holds signal, so the next block starts from silence
+    void clear(ConvolutionReverb* convolver)
+    {
+        clearWetPath(convolver);
+
+        for (auto& oversampler : warmthOversamplers)
+            if (oversampler != nullptr)
+                oversampler->reset();
+
+        for (auto& state : warmthAdaaState)
+            state = {};
+    }
+
+    void resetTanks()
+    {
+        reverb.reset();
+        fdn.reset();
+        economyFdn.reset();
+        tankResampler.reset();
+    }
+
+private:
+    static constexpr int fusedChunkSize = 256;
+    static constexpr int predelayFadeLength = 512;
+
+    // Output channels
+    template <ChannelLayout layout>
+    int numChannelsFor() const noexcept
+    {
+        if constexpr (layout == ChannelLayout::mono)
+            return 1;
+        else if constexpr (layout == ChannelLayout::stereo || layout == ChannelLayout::monoToStereo)
+            return 2;
+        else
+            return configuration.numChannels;
+    }
+
+    // Channels that carry input, and so need a dry copy and a predelay
+    template <ChannelLayout layout>
+    int numInputChannelsFor() const noexcept
+    {
+        if constexpr (layout == ChannelLayout::monoToStereo)
+            return 1;
+        else
+            return numChannelsFor<layout>();
+    }
+
+    using ProcessFunction = void (ReverbChain::*)(juce::AudioBuffer<SampleType>&, ConvolutionReverb*);
+
+    static SampleType dryGainFor(float mix) noexcept { return (SampleType) (2.0f * (1.0f - mix)); }
+
+    int getLongestTankDelay() const noexcept
+    {
+        if (configuration.layout == ChannelLayout::surround)
+            return fdn.getLongestDelayInSamples();
+        if (currentAlgorithm == ReverbSettings::freeverbAlgorithm)
+            return reverb.getLongestDelayInSamples();
+        if (currentQuality == ReverbSettings::economyQuality)
+            return economyFdn.getLongestDelayInSamples();
+        return fdn.getLongestDelayInSamples();
+    }
+
+    // The tank resampler's delay comes off the predelay (while the
+    // decimated tank is running)
+    int toPredelaySamples(float delayMs) const noexcept
+    {
+        const int compensation = usesTankResampler() ? tankResampler.getLatencySamples() : 0;
+        return juce::jlimit(0, maxDelayInSamples, juce::roundToInt(delayMs * 0.001 * sampleRate) - compensation);
+    }
+
+    bool usesTankResampler() const noexcept
+    {
+        return tankResampler.isActive()
+            && (configuration.layout == ChannelLayout::surround || currentAlgorithm != ReverbSettings::convolutionAlgorithm);
+    }
+
+    // Decimation factor for the tank: the largest of 4, 2 and 1 that keeps
+    // it at 44.1 kHz or more, the rates it was tuned at. That is 2 at 88.2
+    // and 96 kHz and 4 from 176.4 kHz up. The wet passband then ends at
+    // 0.36 of the reduced rate (16 kHz at a 44.1 kHz tank), where the
+    // half-band filters start to roll off; the damping and the high-cut
+    // leave little above that in a tail anyway. It depends on the rate
+    // alone, so the same settings sound the same whenever the plugin was
+    // prepared.
+    static int tankDecimationFor(double rate) noexcept
+    {
+        const double minTankRate = 44100.0;
+
+        for (int factor = 4; factor > 1; factor /= 2)
+            if (rate / factor >= minTankRate)
+                return factor;
+        return 1;
+    }
+
+    juce::dsp::Oversampling<SampleType>* getWarmthOversampler() const noexcept
+    {
+        return currentWarmthMode == ReverbSettings::oversampled2xWarmth ? warmthOversamplers[0].get()
+             : currentWarmthMode == ReverbSettings::oversampled4xWarmth ? warmthOversamplers[1].get()
+             : nullptr;
+    }
+
+    //==============================================================================
+    template <ChannelLayout layout>
+    void processLayout(juce::AudioBuffer<SampleType>& buffer, ConvolutionReverb* convolver)
+    {
+        const int numChannels = numChannelsFor<layout>();
+        jassert(buffer.getNumChannels() >= numChannels);
+
+        const int numSamples = buffer.getNumSamples();
+
+        // Pan gains (simple linear law) are folded into the Warmth stage's
+        // output gain, so panning costs no pass of its own. Panning only
+        // applies to stereo signals.
+        SampleType channelGains[maxChannels];
+        std::fill(std::begin(channelGains), std::end(channelGains), SampleType(1));
+
+        if constexpr (layout == ChannelLayout::stereo || layout == ChannelLayout::monoToStereo) {
+            const auto pan = (SampleType) settings.pan;
+            if (std::abs(pan) > SampleType(0.01)) {
+                channelGains[0] = (pan <= 0) ? SampleType(1) : (1 - pan);
+                channelGains[1] = (pan >= 0) ? SampleType(1) : (1 + pan);
+            }
+        }
+
+        for (int start = 0; start < numSamples; start += fusedChunkSize) {
+            SampleType* channels[maxChannels];
+            for (int channel = 0; channel < numChannels; ++channel)
+                channels[channel] = buffer.getWritePointer(channel, start);
+
+            juce::AudioBuffer<SampleType> chunk(channels, numChannels, juce::jmin(fusedChunkSize, numSamples - start));
+            processChunk<layout>(chunk, convolver, channelGains);
+        }
+    }
+
+    // One pass of the full chain over a chunk of at most fusedChunkSize samples
+    template <ChannelLayout layout>
+    void processChunk(juce::AudioBuffer<SampleType>& chunk, ConvolutionReverb* convolver, const SampleType* channelGains)
+    {
+        const int numChannels = numChannelsFor<layout>();
+        const int numInputChannels = numInputChannelsFor<layout>();
+        const int numSamples = chunk.getNumSamples();
+        SampleType* left = chunk.getWritePointer(0);
+        SampleType* right = numChannels > 1 ? chunk.getWritePointer(1) : nullptr;
+
+        const SampleType dryGain = dryGainFor(settings.mix);
+
+        // Fully dry and the tail is gone: only the dry gain, Warmth and pan remain
+        if (wetPathIdle) {
+            if constexpr (layout == ChannelLayout::monoToStereo)
+                chunk.copyFrom(1, 0, chunk, 0, 0, numSamples);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                chunk.applyGainRamp(channel, 0, numSamples, lastDryGain, dryGain);
+            lastDryGain = dryGain;
+
+            ELOUREVERB_PROFILE_STAGE(profiler, warmthStage, numSamples);
+            applyWarmth(chunk, numChannels, channelGains);
+            return;
+        }
+
+        // Keep the dry signal aside (not needed at 100% wet), then delay what
+        // feeds the tank
+        const bool hasDry = dryGain > 0 || lastDryGain > 0;
+        if (hasDry)
+            for (int channel = 0; channel < numInputChannels; ++channel)
+                dryBuffer.copyFrom(channel, 0, chunk, channel, 0, numSamples);
+
+        {
+            ELOUREVERB_PROFILE_STAGE(profiler, predelayStage, numSamples);
+            applyPredelay(chunk, numInputChannels);
+        }
+
+        // While the wet gain fades out towards mix = 0, the tank gets no new input
+        if (settings.mix <= 0.0f)
+            chunk.clear();
+
+        {
+            ELOUREVERB_PROFILE_STAGE(profiler, tankStage, numSamples);
+
+            if constexpr (layout == ChannelLayout::surround) {
+                processTankChunk<layout>(chunk);
+            } else if (currentAlgorithm == ReverbSettings::convolutionAlgorithm) {
+                // The convolver always runs at the host rate
+                if (convolver == nullptr) {
+                    chunk.clear(); // No IR loaded yet: dry only
+                } else if constexpr (layout == ChannelLayout::monoToStereo) {
+                    // Each IR channel needs the input
+                    chunk.copyFrom(1, 0, chunk, 0, 0, numSamples);
+                    processConvolution<ChannelLayout::stereo>(*convolver, left, right, numSamples);
+                } else {
+                    processConvolution<layout>(*convolver, left, right, numSamples);
+                }
+            } else {
+                processTankChunk<layout>(chunk);
+            }
+        }
+
+        {
+            ELOUREVERB_PROFILE_STAGE(profiler, filterStage, numSamples);
+
+            if constexpr (layout == ChannelLayout::mono) {
+                wetFilters[0].processMono(left, numSamples);
+            } else {
+                for (int channel = 0; channel + 1 < numChannels; channel += 2)
+                    wetFilters[channel / 2].processStereo(chunk.getWritePointer(channel), chunk.getWritePointer(channel + 1),
+                                                          numSamples);
+                if (numChannels % 2 != 0)
+                    wetFilters[numChannels / 2].processMono(chunk.getWritePointer(numChannels - 1), numSamples);
+            }
+        }
+
+        if (hasDry) {
+            ELOUREVERB_PROFILE_STAGE(profiler, dryMixStage, numSamples);
+            addDrySignal(chunk, numChannels, numInputChannels, dryGain);
+        }
+
+        ELOUREVERB_PROFILE_STAGE(profiler, warmthStage, numSamples);
+        applyWarmth(chunk, numChannels, channelGains);
+    }
+
+    // Runs the tank over a chunk, through the resampler when decimating
+    template <ChannelLayout layout>
+    void processTankChunk(juce::AudioBuffer<SampleType>& chunk) noexcept
+    {
+        if (! tankResampler.isActive()) {
+            processTank<layout>(chunk.getArrayOfWritePointers(), chunk.getNumSamples());
+            return;
+        }
+
+        tankResampler.process(chunk.getArrayOfWritePointers(), numInputChannelsFor<layout>(), numChannelsFor<layout>(),
+                              chunk.getNumSamples(), [this](SampleType* const* channels, int numReduced) {
+                                  processTank<layout>(channels, numReduced);
+                              });
+    }
+
+    // Freeverb or the FDN, in place over the layout's channels
+    template <ChannelLayout layout>
+    void processTank(SampleType* const* channels, int numSamples) noexcept
+    {
+        SampleType* left = channels[0];
+        SampleType* right = numChannelsFor<layout>() > 1 ? channels[1] : nullptr;
+
+        if constexpr (layout == ChannelLayout::surround) {
+            juce::ignoreUnused(left, right);
+            fdn.processMultichannel(channels, numChannelsFor<layout>(), configuration.lfeChannel, numSamples);
+        } else if (currentAlgorithm == ReverbSettings::fdnAlgorithm) {
+            if (currentQuality == ReverbSettings::economyQuality)
+                processFdn<layout>(economyFdn, left, right, numSamples);
+            else
+                processFdn<layout>(fdn, left, right, numSamples);
+        } else if constexpr (layout == ChannelLayout::mono) {
+            reverb.processMono(left, numSamples);
+        } else if (currentQuality == ReverbSettings::economyQuality) {
+            if constexpr (layout == ChannelLayout::monoToStereo)
+                std::memcpy(right, left, sizeof(SampleType) * (size_t) numSamples);
+            reverb.processMidOnly(left, right, numSamples);
+        } else if constexpr (layout == ChannelLayout::monoToStereo) {
+            reverb.processMonoToStereo(left, right, numSamples);
+        } else {
+            reverb.processStereo(left, right, numSamples);
+        }
+    }
+
+    template <ChannelLayout layout, int numLines>
+    static void processFdn(FdnEngine<SampleType, numLines>& engine, SampleType* left, SampleType* right, int numSamples) noexcept
+    {
+        if constexpr (layout == ChannelLayout::stereo)
+            engine.processStereo(left, right, numSamples);
+        else if constexpr (layout == ChannelLayout::monoToStereo)
+            engine.processMonoToStereo(left, right, numSamples);
+        else
+            engine.processMono(left, numSamples);
+    }
+
+    // The convolver is float only, so double samples go through the scratch chunk
+    template <ChannelLayout layout>
+    void processConvolution(ConvolutionReverb& engine, SampleType* left, SampleType* right, int numSamples)
+    {
+        if constexpr (std::is_same_v<SampleType, float>) {
+            if constexpr (layout == ChannelLayout::stereo)
+                engine.processStereo(left, right, numSamples);
+            else
+                engine.processMono(left, numSamples);
+        } else {
+            float* l = convolutionScratch.getWritePointer(0);
+            float* r = convolutionScratch.getWritePointer(1);
+
+            for (int i = 0; i < numSamples; ++i)
+                l[i] = (float) left[i];
+
+            if constexpr (layout == ChannelLayout::stereo) {
+                for (int i = 0; i < numSamples; ++i)
+                    r[i] = (float) right[i];
+
+                engine.processStereo(l, r, numSamples);
+
+                for (int i = 0; i < numSamples; ++i)
+                    right[i] = r[i];
+            } else {
+                juce::ignoreUnused(r, right);
+                engine.processMono(l, numSamples);
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+                left[i] = l[i];
+        }
+    }
+
+    // Clears the predelay, tanks and wet filter, so the wet path restarts from silence
+    void clearWetPath(ConvolutionReverb* convolver)
+    {
+        reverb.reset();
+        fdn.reset();
+        economyFdn.reset();
+        tankResampler.reset();
+        if (convolver != nullptr)
+            convolver->reset();
+        for (auto& wetFilter : wetFilters)
+            wetFilter.reset();
+        predelayBuffer.clear();
+    }
+
+    //==============================================================================
+    void applyWarmth(juce::AudioBuffer<SampleType>& buffer, int numChannels, const SampleType* channelGains)
+    {
+        const auto amount = (SampleType) settings.saturation;
+        const bool active = amount > SampleType(0.01);
+        const SampleType drive = 1 + 15 * amount;
+        const SampleType makeUp = 1 / (1 + amount * 3);
+
+        // Shapes and applies the channel gain in the same pass
+        auto shape = [&](SampleType* samples, int numSamples, int channel) {
+            if (active)
+                Saturator<SampleType>::processTanh(samples, numSamples, drive, channelGains[channel] * makeUp);
+            else if (channelGains[channel] != 1)
+                juce::FloatVectorOperations::multiply(samples, channelGains[channel], numSamples);
+        };
+
+        if (currentWarmthMode == ReverbSettings::adaaWarmth) {
+            for (int channel = 0; channel < numChannels; ++channel) {
+                if (active) {
+                    Saturator<SampleType>::processTanhAdaa(buffer.getWritePointer(channel), buffer.getNumSamples(), drive,
+                                                           channelGains[channel] * makeUp, warmthAdaaState[channel]);
+                } else {
+                    warmthAdaaState[channel] = {}; // Don't resume from a stale sample
+                    shape(buffer.getWritePointer(channel), buffer.getNumSamples(), channel);
+                }
+            }
+            return;
+        }
+
+        auto* oversampler = getWarmthOversampler();
+
+        if (oversampler == nullptr) {
+            for (int channel = 0; channel < numChannels; ++channel)
+                shape(buffer.getWritePointer(channel), buffer.getNumSamples(), channel);
+            return;
+        }
+
+        // The rate change always runs so the reported latency doesn't depend on
+        // the Warmth amount
+        juce::dsp::AudioBlock<SampleType> block(buffer.getArrayOfWritePointers(), (size_t) numChannels,
+                                                (size_t) buffer.getNumSamples());
+
+        for (size_t start = 0; start < block.getNumSamples(); start += (size_t) maxBlockSize) {
+            auto subBlock = block.getSubBlock(start, juce::jmin((size_t) maxBlockSize, block.getNumSamples() - start));
+            auto upsampled = oversampler->processSamplesUp(subBlock);
+
+            for (size_t channel = 0; channel < upsampled.getNumChannels(); ++channel)
+                shape(upsampled.getChannelPointer(channel), (int) upsampled.getNumSamples(), (int) channel);
+
+            oversampler->processSamplesDown(subBlock);
+        }
+    }
+
+    //==============================================================================
+    // Delays the signal feeding the tank. The ring is written and read with at
+    // most two contiguous copies per block instead of wrapping every sample.
+    void applyPredelay(juce::AudioBuffer<SampleType>& buffer, int numChannels)
+    {
+        const int target = toPredelaySamples(settings.predelayMs);
+        const int maxChunk = predelayBufferSize - maxDelayInSamples;
+        if (maxChunk <= 0)
+            return; // Not prepared yet
+
+        for (int start = 0; start < buffer.getNumSamples(); start += maxChunk) {
+            const int num = juce::jmin(maxChunk, buffer.getNumSamples() - start);
+
+            // Start a new crossfade once the previous one has finished
+            if (target != predelaySamples && predelayFadePosition >= predelayFadeLength) {
+                previousPredelaySamples = predelaySamples;
+                predelaySamples = target;
+                predelayFadePosition = 0;
+            }
+
+            for (int channel = 0; channel < numChannels; ++channel) {
+                const SampleType* input = buffer.getReadPointer(channel, start);
+                SampleType* ring = predelayBuffer.getWritePointer(channel);
+
+                const int firstPart = juce::jmin(num, predelayBufferSize - predelayBufferWritePosition);
+                std::memcpy(ring + predelayBufferWritePosition, input, sizeof(SampleType) * (size_t) firstPart);
+                std::memcpy(ring, input + firstPart, sizeof(SampleType) * (size_t) (num - firstPart));
+            }
+
+            for (int channel = 0; channel < numChannels; ++channel) {
+                SampleType* output = buffer.getWritePointer(channel, start);
+                readPredelay(channel, predelaySamples, output, num);
+
+                if (predelayFadePosition < predelayFadeLength) {
+                    SampleType* previous = predelayFadeBuffer.getWritePointer(channel);
+                    const int fadeLength = juce::jmin(num, predelayFadeLength - predelayFadePosition);
+                    readPredelay(channel, previousPredelaySamples, previous, fadeLength);
+
+                    for (int i = 0; i < fadeLength; ++i) {
+                        const SampleType fade = (SampleType) (predelayFadePosition + i) / (SampleType) predelayFadeLength;
+                        output[i] = previous[i] + fade * (output[i] - previous[i]);
+                    }
+                }
+            }
+
+            predelayFadePosition = juce::jmin(predelayFadeLength, predelayFadePosition + num);
+            predelayBufferWritePosition = (predelayBufferWritePosition + num) % predelayBufferSize;
+        }
+    }
+
+    // Copies numSamples that were written 'delay' samples before the current
+    // write position, in at most two contiguous pieces
+    void readPredelay(int channel, int delay, SampleType* dest, int numSamples) const
+    {
+        const SampleType* ring = predelayBuffer.getReadPointer(channel);
+        const int readPosition = (predelayBufferWritePosition - delay + predelayBufferSize) % predelayBufferSize;
+
+        const int firstPart = juce::jmin(numSamples, predelayBufferSize - readPosition);
+        std::memcpy(dest, ring + readPosition, sizeof(SampleType) * (size_t) firstPart);
+        std::memcpy(dest + firstPart, ring, sizeof(SampleType) * (size_t) (numSamples - firstPart));
+    }
+
+    // Mixes the undelayed input back in, ramping from the previous chunk's
+    // gain. A single input channel goes to every output.
+    void addDrySignal(juce::AudioBuffer<SampleType>& buffer, int numChannels, int numInputChannels, SampleType dryGain)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.addFromWithRamp(channel, 0, dryBuffer.getReadPointer(numInputChannels > 1 ? channel : 0),
+                                   buffer.getNumSamples(), lastDryGain, dryGain);
+        lastDryGain = dryGain;
+    }
+
+    //==============================================================================
+    ReverbSettings settings;
+    ChannelConfiguration configuration;
+    ProcessFunction processFunction = &ReverbChain::processLayout<ChannelLayout::stereo>;
+    double sampleRate = 44100.0;
+    int maxBlockSize = 512;
+
+    FreeverbEngine<SampleType> reverb;
+    FdnEngine<SampleType, 16> fdn; // Alternative tank selected by the "algorithm" parameter
+    FdnEngine<SampleType, 8> economyFdn; // Replaces fdn at economy quality (not on surround buses)
+    int currentAlgorithm = ReverbSettings::freeverbAlgorithm;
+    int currentQuality = ReverbSettings::highQuality;
+
+    // Decimation around the Freeverb and FDN tanks (inactive at factor 1)
+    TankResampler<SampleType> tankResampler;
+
+    // Low cut (high pass) and high cut (low pass) on the wet signal, one
+    // filter per channel pair
+    WetFilter<SampleType> wetFilters[maxChannels / 2];
+
+    // Warmth stage: the tanh runs at 2x or 4x through polyphase half-band IIR
+    // filters when selected, so only the nonlinearity pays for the rate change.
+    // The ADAA mode reduces aliasing without changing the rate.
+    std::unique_ptr<juce::dsp::Oversampling<SampleType>> warmthOversamplers[2]; // 2x, 4x
+    typename Saturator<SampleType>::AdaaState warmthAdaaState[maxChannels];
+    int currentWarmthMode = ReverbSettings::standardWarmth;
+
+    // Predelay ring. Delay changes crossfade from the previous read position
+    // to the new one.
+    juce::AudioBuffer<SampleType> predelayBuffer;
+    int predelayBufferWritePosition = 0;
+    int predelayBufferSize = 0;
+    int maxDelayInSamples = 0;
+    int predelaySamples = 0;
+    int previousPredelaySamples = 0;
+    int predelayFadePosition = predelayFadeLength;
+    juce::AudioBuffer<SampleType> predelayFadeBuffer;
+
+    // The engines only produce the wet signal; the dry signal is mixed back
+    // in here so the predelay never touches it
+    juce::AudioBuffer<SampleType> dryBuffer;
+    SampleType lastDryGain = 0;
+
+    bool wetPathIdle = false;
+
+    // Float copy of a chunk for the convolver (double chains only)
+    juce::AudioBuffer<float> convolutionScratch;
+
+    StageProfiler profiler;
+
+    JUCE_LEAK_DETECTOR(ReverbChain)
+};
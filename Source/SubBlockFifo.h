@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    SubBlockFifo.h
+
+    Re-blocks host buffers of any size into fixed-size sub-blocks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Runs a callback on fixed blocks of blockSize samples, whatever size the
+    host's buffers are.
+
+    One buffer holds the sub-block being filled. As each host sample comes
+    in, it is swapped with the processed sample at the same position, which
+    came out of the previous sub-block. When the buffer is full, the callback
+    processes it in place. The output is delayed by exactly blockSize
+    samples. That delay is constant, so it can be reported as latency.
+
+    The callback always sees the same sample grid. A 1-sample host buffer
+    costs a swap per channel, a 8192-sample one costs no more per sample than
+    a 32-sample one, and the output doesn't depend on how the host split it.
+*/
+template <typename SampleType>
+class SubBlockFifo
+{
+public:
+    // Allocates, so call this from prepareToPlay
+    void prepare(int numChannels, int newBlockSize)
+    {
+        blockSize = juce::jmax(1, newBlockSize);
+        block.setSize(juce::jmax(1, numChannels), blockSize);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        block.clear();
+        position = 0;
+    }
+
+    int getLatencySamples() const noexcept { return blockSize; }
+
+    // processBlock(juce::AudioBuffer<SampleType>&) runs on every completed
+    // sub-block
+    template <typename Callback>
+    void process(juce::AudioBuffer<SampleType>& buffer, Callback&& processBlock)
+    {
+        const int numChannels = juce::jmin(buffer.getNumChannels(), block.getNumChannels());
+        const int numSamples = buffer.getNumSamples();
+
+        for (int done = 0; done < numSamples;) {
+            const int num = juce::jmin(numSamples - done, blockSize - position);
+
+            for (int channel = 0; channel < numChannels; ++channel) {
+                SampleType* io = buffer.getWritePointer(channel, done);
+                std::swap_ranges(io, io + num, block.getWritePointer(channel, position));
+            }
+
+            done += num;
+            position += num;
+
+            if (position == blockSize) {
+                processBlock(block);
+                position = 0;
+            }
+        }
+
+        for (int channel = numChannels; channel < buffer.getNumChannels(); ++channel)
+            buffer.clear(channel, 0, numSamples);
+    }
+
+private:
+    juce::AudioBuffer<SampleType> block;
+    int blockSize = 32;
+    int position = 0;
+
+    JUCE_LEAK_DETECTOR(SubBlockFifo)
+};
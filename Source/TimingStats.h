@@ -0,0 +1,276 @@
+/*
+  ==============================================================================
+
+    TimingStats.h
+
+    CPU time measurement for the audio thread, readable from any thread
+    without locks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Scoped timers around each stage of the chain (see StageProfiler). Off by
+// default, as reading the clock around every stage of every sub-block costs
+// a few nanoseconds per sample. Define ELOUREVERB_PROFILE_STAGES=1 to build
+// them in.
+#ifndef ELOUREVERB_PROFILE_STAGES
+ #define ELOUREVERB_PROFILE_STAGES 0
+#endif
+
+//==============================================================================
+/**
+    Histogram of processing times in nanoseconds per sample, on a log scale
+    with binsPerOctave bins per octave from minimumNs up. Percentiles come
+    back as the upper edge of their bin, so they read high by at most one
+    bin width (9%). Values past the top bin are counted in it.
+
+    Not thread-safe: fill and read it on one thread.
+*/
+class TimingHistogram
+{
+public:
+    static constexpr int binsPerOctave = 8;
+    static constexpr int numOctaves = 18;
+    static constexpr int numBins = binsPerOctave * numOctaves;
+    static constexpr double minimumNs = 0.25;
+
+    void clear() noexcept
+    {
+        std::fill(std::begin(bins), std::end(bins), 0);
+        count = 0;
+    }
+
+    void add(double nsPerSample) noexcept
+    {
+        const double octaves = std::log2(juce::jmax(nsPerSample, minimumNs) / minimumNs);
+        ++bins[juce::jlimit(0, numBins - 1, (int) (octaves * binsPerOctave))];
+        ++count;
+    }
+
+    juce::int64 getCount() const noexcept { return count; }
+
+    // fraction in (0, 1], e.g. 0.99 for the 99th percentile
+    double getPercentile(double fraction) const noexcept
+    {
+        if (count == 0)
+            return 0.0;
+
+        const auto rank = (juce::int64) std::ceil(fraction * (double) count);
+        juce::int64 below = 0;
+        int bin = 0;
+        for (; bin < numBins - 1; ++bin) {
+            below += bins[bin];
+            if (below >= rank)
+                break;
+        }
+
+        return minimumNs * std::exp2((double) (bin + 1) / binsPerOctave);
+    }
+
+private:
+    juce::int64 bins[numBins] {};
+    juce::int64 count = 0;
+};
+
+//==============================================================================
+/**
+    Times each processBlock call (or each run of one stage, for the
+    StageProfiler) and publishes running stats about once a second of audio.
+
+    The audio thread adds one block at a time and, at the end of each
+    window, publishes a TimingSnapshot through a seqlock. getSnapshot() can
+    be polled from any thread (the editor, a host-side monitor) and always
+    returns one consistent window. It never blocks the audio thread.
+
+    Times are per sample, so blocks of different sizes compare. A realtime
+    ratio of 1 means a block took as long to process as it lasts.
+*/
+class BlockTimingStats
+{
+public:
+    struct TimingSnapshot
+    {
+        juce::int64 numBlocks = 0;      // Since prepare()
+        double meanNsPerSample = 0.0;   // Over the last window, weighted by block size
+        double p99NsPerSample = 0.0;
+        double maxNsPerSample = 0.0;
+        double meanRealtimeRatio = 0.0;
+        double p99RealtimeRatio = 0.0;
+        double maxRealtimeRatio = 0.0;
+    };
+
+    // Times one block from construction to destruction
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock(BlockTimingStats& statsToUse, int numSamplesInBlock) noexcept
+            : stats(statsToUse), numSamples(numSamplesInBlock), start(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedBlock() noexcept { stats.addBlock(juce::Time::getHighResolutionTicks() - start, numSamples); }
+
+    private:
+        BlockTimingStats& stats;
+        const int numSamples;
+        const juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+    // Not while the audio thread is running
+    void prepare(double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        nsPerTick = 1.0e9 / (double) juce::Time::getHighResolutionTicksPerSecond();
+        windowLength = juce::jmax(1, (int) sampleRate);
+        numBlocks = 0;
+        startWindow();
+    }
+
+    // Audio thread
+    void addBlock(juce::int64 ticks, int numSamples) noexcept
+    {
+        ++numBlocks;
+        if (numSamples <= 0)
+            return;
+
+        const double nsPerSample = (double) ticks * nsPerTick / numSamples;
+        histogram.add(nsPerSample);
+        windowTicks += ticks;
+        windowSamples += numSamples;
+        windowMax = juce::jmax(windowMax, nsPerSample);
+
+        if (windowSamples >= windowLength) {
+            publish();
+            startWindow();
+        }
+    }
+
+    // Any thread
+    TimingSnapshot getSnapshot() const noexcept
+    {
+        TimingSnapshot snapshot;
+        juce::uint32 before = 0, after = 0;
+
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            snapshot.numBlocks = publishedBlocks.load(std::memory_order_relaxed);
+            snapshot.meanNsPerSample = publishedMean.load(std::memory_order_relaxed);
+            snapshot.p99NsPerSample = publishedP99.load(std::memory_order_relaxed);
+            snapshot.maxNsPerSample = publishedMax.load(std::memory_order_relaxed);
+            const double rate = publishedSampleRate.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+
+            snapshot.meanRealtimeRatio = snapshot.meanNsPerSample * rate * 1.0e-9;
+            snapshot.p99RealtimeRatio = snapshot.p99NsPerSample * rate * 1.0e-9;
+            snapshot.maxRealtimeRatio = snapshot.maxNsPerSample * rate * 1.0e-9;
+        } while ((before & 1) != 0 || before != after);
+
+        return snapshot;
+    }
+
+private:
+    void startWindow() noexcept
+    {
+        histogram.clear();
+        windowTicks = 0;
+        windowSamples = 0;
+        windowMax = 0.0;
+    }
+
+    void publish() noexcept
+    {
+        const juce::uint32 start = sequence.load(std::memory_order_relaxed);
+        sequence.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        publishedBlocks.store(numBlocks, std::memory_order_relaxed);
+        publishedMean.store((double) windowTicks * nsPerTick / (double) windowSamples, std::memory_order_relaxed);
+        publishedP99.store(juce::jmin(histogram.getPercentile(0.99), windowMax), std::memory_order_relaxed);
+        publishedMax.store(windowMax, std::memory_order_relaxed);
+        publishedSampleRate.store(sampleRate, std::memory_order_relaxed);
+
+        sequence.store(start + 2, std::memory_order_release);
+    }
+
+    // Audio thread only
+    TimingHistogram histogram;
+    double sampleRate = 44100.0, nsPerTick = 1.0;
+    int windowLength = 44100;
+    juce::int64 numBlocks = 0, windowTicks = 0, windowSamples = 0;
+    double windowMax = 0.0;
+
+    // Published snapshot, odd sequence while it is being written
+    std::atomic<juce::uint32> sequence { 0 };
+    std::atomic<juce::int64> publishedBlocks { 0 };
+    std::atomic<double> publishedMean { 0.0 }, publishedP99 { 0.0 }, publishedMax { 0.0 };
+    std::atomic<double> publishedSampleRate { 44100.0 };
+};
+
+//==============================================================================
+/**
+    One BlockTimingStats per stage of the reverb chain, so a slow machine
+    shows which stage to switch to economy and a kernel regression shows up
+    in its own stage.
+
+    The chain marks its stages with ELOUREVERB_PROFILE_STAGE, which compiles
+    to nothing unless ELOUREVERB_PROFILE_STAGES is set. Without it the
+    snapshots stay empty.
+*/
+class StageProfiler
+{
+public:
+    enum Stage
+    {
+        predelayStage,
+        tankStage,      // Freeverb, FDN or convolver, with any resampling
+        filterStage,    // Wet low and high cut
+        dryMixStage,
+        warmthStage,    // Saturation, with the pan gains folded in
+        numStages
+    };
+
+    static const char* getStageName(int stage) noexcept
+    {
+        static const char* const names[numStages] = { "Predelay", "Tank", "Filters", "Dry mix", "Warmth + pan" };
+        return juce::isPositiveAndBelow(stage, (int) numStages) ? names[stage] : "";
+    }
+
+    class ScopedStage
+    {
+    public:
+        ScopedStage(StageProfiler& profilerToUse, Stage stageToTime, int numSamplesInStage) noexcept
+            : timer(profilerToUse.stages[stageToTime], numSamplesInStage) {}
+
+    private:
+        BlockTimingStats::ScopedBlock timer;
+    };
+
+    // Not while the audio thread is running
+    void prepare(double sampleRate) noexcept
+    {
+        for (auto& stage : stages)
+            stage.prepare(sampleRate);
+    }
+
+    // Any thread
+    BlockTimingStats::TimingSnapshot getSnapshot(int stage) const noexcept
+    {
+        return juce::isPositiveAndBelow(stage, (int) numStages) ? stages[stage].getSnapshot()
+                                                                : BlockTimingStats::TimingSnapshot();
+    }
+
+private:
+    BlockTimingStats stages[numStages];
+};
+
+#if ELOUREVERB_PROFILE_STAGES
+ #define ELOUREVERB_PROFILE_STAGE(profiler, stage, numSamples) \
+    const StageProfiler::ScopedStage JUCE_JOIN_MACRO(stageTimer_, __LINE__)(profiler, StageProfiler::stage, numSamples)
+#else
+ #define ELOUREVERB_PROFILE_STAGE(profiler, stage, numSamples)
+#endif
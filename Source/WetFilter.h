@@ -0,0 +1,178 @@
+/*
+  ==============================================================================
+
+    WetFilter.h
+
+    Low-cut / high-cut filtering of the reverb's wet signal.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A high-pass (low cut) and a low-pass (high cut) biquad in series, applied
+    to the wet signal only.
+
+    Both channels are filtered together: left and right sit in lanes 0 and 1
+    of one SIMD register, so each biquad step is a handful of vector ops for
+    the pair. The coefficients come from juce::IIRCoefficients. They are only
+    recomputed when a cutoff actually changes. A stage whose cutoff is at the
+    end of its range is switched off and costs nothing.
+
+    SampleType is float or double. A double register still has two lanes
+    (SSE2 / NEON), so the pair always fits in one.
+*/
+template <typename SampleType>
+class WetFilter
+{
+public:
+    static constexpr float minimumLowCut = 20.0f;     // Low cut is off at this value
+    static constexpr float maximumHighCut = 20000.0f; // High cut is off at this value
+
+    WetFilter()
+    {
+        std::fill(std::begin(frames), std::end(frames), SampleType());
+    }
+
+    void setSampleRate(double newSampleRate) noexcept
+    {
+        jassert(newSampleRate > 0);
+        sampleRate = newSampleRate;
+
+        // Force the next setCutoffs() to recompute both stages
+        lowCutFrequency = -1.0f;
+        highCutFrequency = -1.0f;
+        reset();
+    }
+
+    void setCutoffs(float lowCut, float highCut) noexcept
+    {
+        if (lowCut != lowCutFrequency) {
+            lowCutFrequency = lowCut;
+            lowCut = juce::jmin(lowCut, (float) (0.45 * sampleRate));
+            lowCutStage.setActive(lowCutFrequency > minimumLowCut,
+                                  juce::IIRCoefficients::makeHighPass(sampleRate, lowCut));
+        }
+
+        if (highCut != highCutFrequency) {
+            highCutFrequency = highCut;
+            highCut = juce::jmin(highCut, (float) (0.45 * sampleRate));
+            highCutStage.setActive(highCutFrequency < maximumHighCut,
+                                   juce::IIRCoefficients::makeLowPass(sampleRate, highCut));
+        }
+    }
+
+    void reset() noexcept
+    {
+        lowCutStage.reset();
+        highCutStage.reset();
+    }
+
+    bool isActive() const noexcept { return lowCutStage.active || highCutStage.active; }
+
+    void processStereo(SampleType* left, SampleType* right, int numSamples) noexcept
+    {
+        process<2>(left, right, numSamples);
+    }
+
+    void processMono(SampleType* samples, int numSamples) noexcept
+    {
+        process<1>(samples, nullptr, numSamples);
+    }
+
+private:
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+
+    static constexpr int lanesPerVec = (int) Vec::SIMDNumElements;
+    static constexpr int maxSubBlockSize = 64;
+
+    static_assert(lanesPerVec >= 2, "left and right need a lane each");
+
+    template <int numChannels>
+    void process(SampleType* left, SampleType* right, int numSamples) noexcept
+    {
+        if (! isActive())
+            return;
+
+        for (int start = 0; start < numSamples; start += maxSubBlockSize) {
+            const int num = juce::jmin(maxSubBlockSize, numSamples - start);
+            SampleType* l = left + start;
+            SampleType* r = numChannels > 1 ? right + start : nullptr;
+
+            for (int i = 0; i < num; ++i) {
+                frames[i * lanesPerVec] = l[i];
+                frames[i * lanesPerVec + 1] = numChannels > 1 ? r[i] : SampleType();
+            }
+
+            for (int i = 0; i < num; ++i) {
+                auto x = Vec::fromRawArray(frames + i * lanesPerVec);
+
+                if (lowCutStage.active)
+                    x = lowCutStage.process(x);
+                if (highCutStage.active)
+                    x = highCutStage.process(x);
+
+                x.copyToRawArray(frames + i * lanesPerVec);
+            }
+
+            for (int i = 0; i < num; ++i)
+                l[i] = frames[i * lanesPerVec];
+
+            if constexpr (numChannels > 1)
+                for (int i = 0; i < num; ++i)
+                    r[i] = frames[i * lanesPerVec + 1];
+        }
+    }
+
+    //==============================================================================
+    // Transposed direct form II biquad running on every lane at once
+    struct Stage
+    {
+        void setActive(bool shouldBeActive, const juce::IIRCoefficients& c) noexcept
+        {
+            // Coming back on after being off must not replay stale state
+            if (shouldBeActive && ! active)
+                reset();
+
+            active = shouldBeActive;
+            b0 = Vec::expand(static_cast<SampleType>(c.coefficients[0]));
+            b1 = Vec::expand(static_cast<SampleType>(c.coefficients[1]));
+            b2 = Vec::expand(static_cast<SampleType>(c.coefficients[2]));
+            a1 = Vec::expand(static_cast<SampleType>(c.coefficients[3]));
+            a2 = Vec::expand(static_cast<SampleType>(c.coefficients[4]));
+        }
+
+        void reset() noexcept
+        {
+            s1 = Vec::expand(SampleType());
+            s2 = Vec::expand(SampleType());
+        }
+
+        Vec process(Vec x) noexcept
+        {
+            const auto y = b0 * x + s1;
+            s1 = b1 * x - a1 * y + s2;
+            s2 = b2 * x - a2 * y;
+            return y;
+        }
+
+        Vec b0, b1, b2, a1, a2;
+        Vec s1 = Vec::expand(SampleType()), s2 = Vec::expand(SampleType());
+        bool active = false;
+    };
+
+    //==============================================================================
+    Stage lowCutStage, highCutStage;
+    double sampleRate = 44100.0;
+    float lowCutFrequency = -1.0f;
+    float highCutFrequency = -1.0f;
+
+    // Interleaved sub-block, one register-sized frame per sample (unused lanes stay 0)
+    alignas(Vec::SIMDRegisterSize) SampleType frames[maxSubBlockSize * lanesPerVec];
+
+    JUCE_LEAK_DETECTOR(WetFilter)
+};
@@ -0,0 +1,281 @@
+/*
+  ==============================================================================
+
+    AllocationTests.cpp
+
+    Drives processBlock through every bus layout, precision and parameter
+    combination, and through the state transitions (IR swaps, sleep and
+    wake-up, algorithm, quality and Warmth switches) at host block sizes of
+    1 and 8192, with the allocation trap armed. Fails on any allocation on
+    the audio thread.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+#if ! ELOUREVERB_ALLOCATION_TRAP
+ #error "The allocation tests need ELOUREVERB_ALLOCATION_TRAP=1"
+#endif
+
+//==============================================================================
+class AllocationTests : public juce::UnitTest
+{
+public:
+    AllocationTests() : juce::UnitTest("Audio thread allocations", "ElouReverb") {}
+
+    void runTest() override
+    {
+        // Different lengths and rates, so a swap also changes the resampling
+        const juce::File impulseFiles[] = { writeImpulseResponse(48000.0, 1.0, 1),
+                                            writeImpulseResponse(44100.0, 0.25, 2) };
+
+        for (const auto& layout : getLayouts()) {
+            for (const auto precision : { juce::AudioProcessor::singlePrecision, juce::AudioProcessor::doublePrecision }) {
+                for (const double sampleRate : { 44100.0, 96000.0, 192000.0 }) {
+                    beginTest(describe(layout, precision, sampleRate));
+
+                    ElouReverbAudioProcessor processor;
+                    expect(processor.setBusesLayout(layout), "layout not supported");
+                    processor.setProcessingPrecision(precision);
+                    processor.setRateAndBufferSizeDetails(sampleRate, maxBlockSize);
+                    processor.prepareToPlay(sampleRate, maxBlockSize);
+
+                    const int before = ScopedAllocationTrap::getNumTrappedAllocations();
+                    sweepParameters(processor);
+
+                    // Again with an IR, which the audio thread picks up mid-stream
+                    loadImpulseResponse(processor, impulseFiles[0]);
+                    sweepParameters(processor);
+
+                    for (const int blockSize : { 1, maxBlockSize })
+                        runTransitions(processor, sampleRate, blockSize, impulseFiles);
+
+                    expectEquals(ScopedAllocationTrap::getNumTrappedAllocations() - before, 0,
+                                 "allocations on the audio thread");
+                    processor.releaseResources();
+                }
+            }
+        }
+
+        for (const auto& file : impulseFiles)
+            file.deleteFile();
+    }
+
+private:
+    static constexpr int maxBlockSize = 8192;
+    static constexpr int sweepBlockSize = 512;  // Longest random block in a sweep
+
+    static juce::Array<juce::AudioProcessor::BusesLayout> getLayouts()
+    {
+        juce::Array<juce::AudioProcessor::BusesLayout> layouts;
+
+        auto add = [&layouts](const juce::AudioChannelSet& input, const juce::AudioChannelSet& output) {
+            juce::AudioProcessor::BusesLayout layout;
+            layout.inputBuses.add(input);
+            layout.outputBuses.add(output);
+            layouts.add(layout);
+        };
+
+        add(juce::AudioChannelSet::mono(), juce::AudioChannelSet::mono());
+        add(juce::AudioChannelSet::stereo(), juce::AudioChannelSet::stereo());
+        add(juce::AudioChannelSet::mono(), juce::AudioChannelSet::stereo());
+        add(juce::AudioChannelSet::create5point1(), juce::AudioChannelSet::create5point1());
+        add(juce::AudioChannelSet::create7point1(), juce::AudioChannelSet::create7point1());
+        add(juce::AudioChannelSet::create7point1point4(), juce::AudioChannelSet::create7point1point4());
+        return layouts;
+    }
+
+    static juce::String describe(const juce::AudioProcessor::BusesLayout& layout,
+                                 juce::AudioProcessor::ProcessingPrecision precision, double sampleRate)
+    {
+        return layout.getMainInputChannelSet().getDescription() + " -> "
+             + layout.getMainOutputChannelSet().getDescription()
+             + (precision == juce::AudioProcessor::doublePrecision ? ", double, " : ", float, ")
+             + juce::String(sampleRate) + " Hz";
+    }
+
+    // A decaying noise burst, long enough for the convolver to run its tail
+    // on the worker thread
+    static juce::File writeImpulseResponse(double sampleRate, double lengthSeconds, int seed)
+    {
+        juce::AudioBuffer<float> impulse(2, static_cast<int>(sampleRate * lengthSeconds));
+        juce::Random noise(seed);
+
+        for (int channel = 0; channel < impulse.getNumChannels(); ++channel)
+            for (int i = 0; i < impulse.getNumSamples(); ++i)
+                impulse.setSample(channel, i, (noise.nextFloat() * 2.0f - 1.0f) * std::exp(-static_cast<float>(i) / 8000.0f));
+
+        const juce::File file = juce::File::createTempFile(".wav");
+        std::unique_ptr<juce::OutputStream> stream = file.createOutputStream();
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate, 2, 24, {}, 0));
+
+        if (writer != nullptr) {
+            stream.release(); // Owned by the writer now
+            writer->writeFromAudioSampleBuffer(impulse, 0, impulse.getNumSamples());
+        }
+        return file;
+    }
+
+    // The IR is built on the loader thread and picked up by the audio thread,
+    // so keep processing until it is in use
+    void loadImpulseResponse(ElouReverbAudioProcessor& processor, const juce::File& file)
+    {
+        expect(processor.loadImpulseResponse(file), "could not load the impulse response");
+
+        for (int i = 0; i < 2000 && processor.isLoadingImpulseResponse(); ++i) {
+            process(processor, sweepBlockSize, sweepBlockSize, true);
+            juce::Thread::sleep(5);
+        }
+
+        expect(! processor.isLoadingImpulseResponse(), "the impulse response never arrived");
+    }
+
+    static void setChoice(ElouReverbAudioProcessor& processor, const juce::String& parameterID, int index)
+    {
+        auto* parameter = processor.apvts.getParameter(parameterID);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(static_cast<float>(index)));
+    }
+
+    static void setValue(ElouReverbAudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        auto* parameter = processor.apvts.getParameter(parameterID);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    // Each transition in turn, with every block blockSize samples long
+    void runTransitions(ElouReverbAudioProcessor& processor, double sampleRate, int blockSize, const juce::File* impulseFiles)
+    {
+        // Every algorithm, quality and Warmth mode, switched while the tail
+        // is still ringing
+        for (int algorithm = ReverbSettings::freeverbAlgorithm; algorithm <= ReverbSettings::convolutionAlgorithm; ++algorithm) {
+            setChoice(processor, "algorithm", algorithm);
+
+            for (int quality = ReverbSettings::highQuality; quality <= ReverbSettings::economyQuality; ++quality) {
+                setChoice(processor, "quality", quality);
+
+                for (int warmthMode = ReverbSettings::standardWarmth; warmthMode <= ReverbSettings::adaaWarmth; ++warmthMode) {
+                    setChoice(processor, "warmthMode", warmthMode);
+                    setValue(processor, "saturation", 0.5f);
+                    process(processor, blockSize, 2048, true);
+                }
+            }
+        }
+
+        // IR swaps while the convolver is running, and one while it isn't
+        setChoice(processor, "algorithm", ReverbSettings::convolutionAlgorithm);
+        for (int swap = 0; swap < 3; ++swap) {
+            loadImpulseResponse(processor, impulseFiles[(swap + 1) % 2]);
+            process(processor, blockSize, 4096, true);
+        }
+
+        setChoice(processor, "algorithm", ReverbSettings::freeverbAlgorithm);
+        loadImpulseResponse(processor, impulseFiles[0]);
+        process(processor, blockSize, 2048, true);
+
+        // Sleep and wake-up in every algorithm, with short tails
+        setValue(processor, "roomSize", 0.1f);
+        setValue(processor, "predelay", 0.0f);
+        setValue(processor, "mix", 0.5f);
+
+        setChoice(processor, "warmthMode", ReverbSettings::standardWarmth);
+
+        for (int algorithm = ReverbSettings::freeverbAlgorithm; algorithm <= ReverbSettings::convolutionAlgorithm; ++algorithm) {
+            setChoice(processor, "algorithm", algorithm);
+            process(processor, blockSize, 4096, true);
+
+            // The tail is to -60 dB and the silence floor is at -120 dB, and
+            // the predelay line has to empty first
+            const int maxSilence = static_cast<int>((processor.getTailLengthSeconds() * 2.0 + 2.0) * sampleRate);
+            for (int silence = 0; silence < maxSilence && ! processor.isSleeping(); silence += blockSize)
+                process(processor, blockSize, blockSize, false);
+
+            expect(processor.isSleeping(), "never went to sleep");
+
+            // Input has to get through the sub-block FIFO before it wakes it
+            process(processor, blockSize, juce::jmax(blockSize, 64), true);
+            expect(! processor.isSleeping(), "didn't wake up");
+        }
+    }
+
+    // Every combination of the choice parameters. For each, the continuous
+    // parameters go to their minimum, centre and maximum, then to two random
+    // settings.
+    void sweepParameters(ElouReverbAudioProcessor& processor)
+    {
+        juce::Array<juce::AudioParameterChoice*> choices;
+        juce::Array<juce::RangedAudioParameter*> continuous;
+
+        for (auto* parameter : processor.getParameters()) {
+            if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(parameter))
+                choices.add(choice);
+            else if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+                continuous.add(ranged);
+        }
+
+        int numCombinations = 1;
+        for (auto* choice : choices)
+            numCombinations *= choice->choices.size();
+
+        for (int combination = 0; combination < numCombinations; ++combination) {
+            int remaining = combination;
+            for (auto* choice : choices) {
+                const int numChoices = choice->choices.size();
+                choice->setValueNotifyingHost(choice->convertTo0to1(static_cast<float>(remaining % numChoices)));
+                remaining /= numChoices;
+            }
+
+            for (int pass = 0; pass < 5; ++pass) {
+                for (auto* parameter : continuous)
+                    parameter->setValueNotifyingHost(pass < 3 ? static_cast<float>(pass) * 0.5f : random.nextFloat());
+
+                if (processor.isUsingDoublePrecision())
+                    processBlocks(processor, doubleBuffer);
+                else
+                    processBlocks(processor, floatBuffer);
+            }
+        }
+    }
+
+    // Noise then silence, in blocks of random size, so the sub-block FIFO,
+    // the sleep check and the wake-up all run
+    template <typename SampleType>
+    void processBlocks(ElouReverbAudioProcessor& processor, juce::AudioBuffer<SampleType>& buffer)
+    {
+        for (int block = 0; block < 8; ++block)
+            processBlock(processor, buffer, 1 + random.nextInt(sweepBlockSize), block < 4);
+    }
+
+    // numSamples of noise or silence, in blocks of blockSize
+    void process(ElouReverbAudioProcessor& processor, int blockSize, int numSamples, bool noise)
+    {
+        for (int done = 0; done < numSamples; done += blockSize) {
+            if (processor.isUsingDoublePrecision())
+                processBlock(processor, doubleBuffer, juce::jmin(blockSize, numSamples - done), noise);
+            else
+                processBlock(processor, floatBuffer, juce::jmin(blockSize, numSamples - done), noise);
+        }
+    }
+
+    template <typename SampleType>
+    void processBlock(ElouReverbAudioProcessor& processor, juce::AudioBuffer<SampleType>& buffer, int numSamples, bool noise)
+    {
+        const int numChannels = processor.getTotalNumOutputChannels();
+        buffer.setSize(numChannels, numSamples, false, false, true);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.setSample(channel, i, noise ? static_cast<SampleType>(random.nextFloat() - 0.5f) : SampleType(0));
+
+        processor.processBlock(buffer, midi);
+    }
+
+    juce::Random random { 0x5eed };
+    juce::MidiBuffer midi;
+    juce::AudioBuffer<float> floatBuffer;
+    juce::AudioBuffer<double> doubleBuffer;
+};
+
+static AllocationTests allocationTests;
@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Runs the ElouReverb unit tests. Exits with 1 if any of them failed, so
+    it can gate a build.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+//==============================================================================
+int main (int, char*[])
+{
+    // The processor starts a timer, which needs a message manager
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory("ElouReverb");
+
+    int numFailures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        numFailures += runner.getResult(i)->failures;
+
+    return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+    SaturationTests.cpp
+
+    Checks the ADAA Warmth curve against the curve it anti-aliases, and
+    compares its CPU cost with the oversampled Warmth modes.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/Saturation.h"
+
+//==============================================================================
+class SaturationTests : public juce::UnitTest
+{
+public:
+    SaturationTests() : juce::UnitTest("Warmth saturation", "ElouReverb") {}
+
+    void runTest() override
+    {
+        beginTest("ADAA averages the Pade curve");
+        checkAverages<float>(2.0e-6);
+        checkAverages<double>(1.0e-6);
+
+        beginTest("ADAA settles on the Pade curve");
+        checkSettling<float>();
+        checkSettling<double>();
+
+        beginTest("CPU against oversampling");
+        compareCpu();
+    }
+
+private:
+    // Simpson's rule on the approximant itself, in double precision
+    static double referenceAverage(double x0, double x1)
+    {
+        if (x0 == x1)
+            return Saturator<double>::tanh(x0);
+
+        const int numIntervals = 20000;
+        const double step = (x1 - x0) / numIntervals;
+        double sum = 0.0;
+
+        for (int i = 0; i <= numIntervals; ++i) {
+            const double weight = (i == 0 || i == numIntervals) ? 1.0 : (i % 2 == 1 ? 4.0 : 2.0);
+            sum += weight * Saturator<double>::tanh(x0 + i * step);
+        }
+        return sum * step / 3.0 / (x1 - x0);
+    }
+
+    // Random pairs across and past the clamp, close pairs and equal pairs
+    template <typename SampleType>
+    void checkAverages(double tolerance)
+    {
+        juce::Random random(1);
+        double maxError = 0.0;
+
+        for (int i = 0; i < 3000; ++i) {
+            const auto x0 = (SampleType) ((random.nextFloat() * 2.0f - 1.0f) * 12.0f);
+            const auto x1 = i % 3 == 0 ? x0
+                          : i % 3 == 1 ? x0 + (SampleType) ((random.nextFloat() - 0.5f) * 1.0e-3f)
+                                       : (SampleType) ((random.nextFloat() * 2.0f - 1.0f) * 12.0f);
+
+            const double error = std::abs((double) Saturator<SampleType>::tanhAverage(x0, x1) - referenceAverage(x0, x1));
+            maxError = juce::jmax(maxError, error);
+        }
+
+        expect(maxError < tolerance, "ADAA error " + juce::String(maxError));
+    }
+
+    // A constant input comes out as the curve at that input, at unity gain
+    template <typename SampleType>
+    void checkSettling()
+    {
+        for (const SampleType input : { SampleType(-0.4), SampleType(0.05), SampleType(0.3), SampleType(0.9) }) {
+            typename Saturator<SampleType>::AdaaState state;
+            std::vector<SampleType> samples(512, input);
+            Saturator<SampleType>::processTanhAdaa(samples.data(), (int) samples.size(), SampleType(4), SampleType(1), state);
+
+            const double error = std::abs((double) samples.back() - (double) Saturator<SampleType>::tanh(input * 4));
+            expect(error < 1.0e-5, "settled " + juce::String(error) + " away from the curve");
+        }
+    }
+
+    // Stereo noise through each mode, in the chain's 256-sample chunks. The
+    // oversampled modes use the same filters as the Warmth stage.
+    void compareCpu()
+    {
+        const int numChannels = 2;
+        const int chunkSize = 256;
+        const int numChunks = 2000;
+        const float drive = 8.0f;
+
+        juce::AudioBuffer<float> buffer(numChannels, chunkSize);
+        juce::Random random(2);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < chunkSize; ++i)
+                buffer.setSample(channel, i, random.nextFloat() - 0.5f);
+
+        Saturator<float>::AdaaState states[numChannels];
+        const double adaa = timePerSample(numChunks * chunkSize, [&] {
+            for (int chunk = 0; chunk < numChunks; ++chunk)
+                for (int channel = 0; channel < numChannels; ++channel)
+                    Saturator<float>::processTanhAdaa(buffer.getWritePointer(channel), chunkSize, drive, 0.5f, states[channel]);
+        });
+
+        logMessage("ADAA: " + juce::String(adaa, 1) + " ns per stereo sample");
+
+        for (const int order : { 1, 2 }) {
+            juce::dsp::Oversampling<float> oversampler((size_t) numChannels, (size_t) order,
+                                                       juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+            oversampler.initProcessing((size_t) chunkSize);
+
+            const double oversampled = timePerSample(numChunks * chunkSize, [&] {
+                for (int chunk = 0; chunk < numChunks; ++chunk) {
+                    juce::dsp::AudioBlock<float> block(buffer);
+                    auto upsampled = oversampler.processSamplesUp(block);
+
+                    for (size_t channel = 0; channel < upsampled.getNumChannels(); ++channel)
+                        Saturator<float>::processTanh(upsampled.getChannelPointer(channel), (int) upsampled.getNumSamples(), drive, 0.5f);
+
+                    oversampler.processSamplesDown(block);
+                }
+            });
+
+            logMessage(juce::String(1 << order) + "x oversampled: " + juce::String(oversampled, 1)
+                       + " ns per stereo sample, ADAA takes " + juce::String(100.0 * adaa / oversampled, 0) + "% of that");
+        }
+    }
+
+    template <typename Function>
+    static double timePerSample(int numSamples, Function&& function)
+    {
+        function(); // Warm up the caches
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        function();
+        const auto ticks = juce::Time::getHighResolutionTicks() - start;
+
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / numSamples;
+    }
+};
+
+static SaturationTests saturationTests;